@@ -1,10 +1,18 @@
 #include "Board.h"
+#include "CellGrid.h"
 #include "Game.h"
+#include "GameState.h"
 #include "globals.h"
 #include <iostream>
+#include <cstdint>
+#include <vector>
 
 using namespace std;
 
+// grid values for cells without a ship
+const int EMPTY = -1;
+const int BLOCKED = -2;
+
 class BoardImpl
 {
 public:
@@ -12,50 +20,60 @@ public:
     void clear();
     void block();
     void unblock();
-    bool placeShip(Point topOrLeft, int shipId, Direction dir);
-    bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
+    bool placeShip(Cell topOrLeft, int shipId, Direction dir);
+    bool unplaceShip(Cell topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
-    bool attack(Point p, bool &shotHit, bool &shipDestroyed, int &shipId);
+    bool attack(Cell cell, bool &shotHit, bool &shipDestroyed, int &shipId);
+    int attackBatch(const vector<Cell> &shots, vector<ShotResult> &results);
+    int attackBatch(const vector<Point> &shots, vector<ShotResult> &results);
     bool allShipsDestroyed() const;
+    int shipsLeft() const { return m_shipsLeft; }
+    bool copyShipsTo(GameState &state, int s) const;
+    bool findShip(int shipId, Point &topOrLeft, Direction &dir) const;
+    Cell cellOf(Point p) const { return m_cells.cellOf(p); }
 
 private:
-    bool checkValid(const int length, const int r, const int c, const int cr, const int cc) const;
+    bool isPlaced(int shipId) const { return (m_placed[shipId >> 6] >> (shipId & 63)) & 1; }
+    void setPlaced(int shipId, bool placed);
     const Game &m_game;
-    char m_board[MAXROWS][MAXCOLS];
-    vector<int> existShip;
-    bool check(char sym);
+    const CellGrid &m_cells;
+    vector<int> m_grid;          // what is on each cell, row by row: a ship id, or EMPTY or BLOCKED
+    vector<bool> m_shot;         // which cells have been attacked
+    vector<uint64_t> m_placed;   // one bit per ship id, set while it is on the board
+    vector<int> m_hitsLeft;      // per ship id, cells not yet hit
+    int m_shipsLeft;             // placed ships not yet destroyed
+    vector<Cell> m_shipPos;      // where each placed ship is
+    vector<Direction> m_shipDir; // and which way it points
+    vector<Cell> m_batch;        // the cells of the last salvo given as Points
 };
 
 BoardImpl::BoardImpl(const Game &g)
-    : m_game(g)
+    : m_game(g), m_cells(g.grid()), m_grid(g.rows() * g.cols()), m_shot(g.rows() * g.cols()),
+      m_placed((g.nShips() + 63) / 64), m_hitsLeft(g.nShips()),
+      m_shipPos(g.nShips()), m_shipDir(g.nShips())
 {
     clear();
 }
 
 void BoardImpl::clear()
 {
-    char clear = '.';
-    for (int r = 0; r < m_game.rows(); r++)
-    {
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            m_board[r][c] = clear;
-        }
-    }
-    existShip.clear();
+    fill(m_grid.begin(), m_grid.end(), EMPTY);
+    fill(m_shot.begin(), m_shot.end(), false);
+    fill(m_placed.begin(), m_placed.end(), 0);
+    m_shipsLeft = 0;
 }
 
 void BoardImpl::block()
 {
-    const char block = 'X';
     int half = m_game.rows() * m_game.cols() / 2;
     int count = 0;
     while (count < half)
     { // if block blocked is less than half the cell
         Point it = m_game.randomPoint();
-        if (m_board[it.r][it.c] != block)
+        int &cell = m_grid[it.r * m_game.cols() + it.c];
+        if (cell != BLOCKED)
         {
-            m_board[it.r][it.c] = block;
+            cell = BLOCKED;
             count++;
         }
     }
@@ -63,219 +81,188 @@ void BoardImpl::block()
 
 void BoardImpl::unblock()
 {
-    char block = 'X';
-    char clear = '.';
-    for (int r = 0; r < m_game.rows(); r++) // loop through all cell, clear all that is blocked
+    for (int &cell : m_grid) // loop through all cell, clear all that is blocked
     {
-        for (int c = 0; c < m_game.cols(); c++)
-        {
-            if (m_board[r][c] == block)
-                m_board[r][c] = clear;
-        }
+        if (cell == BLOCKED)
+            cell = EMPTY;
     }
 }
 
-bool BoardImpl::checkValid(const int length, const int r, const int c, const int cr, const int cc) const
+void BoardImpl::setPlaced(int shipId, bool placed)
 {
-    return !(c < 0 || c + length > cc || r < 0 || r >= cr); // helper function check exceed the board
+    if (placed)
+        m_placed[shipId >> 6] |= uint64_t(1) << (shipId & 63);
+    else
+        m_placed[shipId >> 6] &= ~(uint64_t(1) << (shipId & 63));
 }
 
-bool BoardImpl::placeShip(Point topOrLeft, int shipId, Direction dir)
+bool BoardImpl::placeShip(Cell topOrLeft, int shipId, Direction dir)
 {
     if (shipId < 0 || shipId >= m_game.nShips())
         return false;
-    for (size_t i = 0; i < existShip.size(); i++) // check shipId is already used
-    {
-        if (shipId == existShip[i])
-            return false;
-    }
+    if (isPlaced(shipId)) // check shipId is already used
+        return false;
     int length = m_game.shipLength(shipId);
-    if (dir == HORIZONTAL) // check if will be place horizontally
-    {
-        if (!checkValid(length, topOrLeft.r, topOrLeft.c, m_game.rows(), m_game.cols()))
-            return false;
-        for (int c = topOrLeft.c; c < topOrLeft.c + length; c++) // check whether all cells is clear
-        {
-            if (m_board[topOrLeft.r][c] != '.')
-                return false;
-        }
-    }
-    else // check if will be place vertically
+    if (!m_cells.fits(topOrLeft, length, dir)) // check the ship stays on the board
+        return false;
+    const int first = topOrLeft;
+    const int step = m_cells.step(dir == HORIZONTAL ? EAST : SOUTH);
+    for (int i = 0; i < length; i++) // check whether all cells is clear
     {
-        if (!checkValid(length, topOrLeft.c, topOrLeft.r, m_game.cols(), m_game.rows()))
+        if (m_grid[first + i * step] != EMPTY)
             return false;
-        for (int r = topOrLeft.r; r < topOrLeft.r + length; r++) // check whether all cells is clear
-        {
-            if (m_board[r][topOrLeft.c] != '.')
-                return false;
-        }
     }
     // At this point the ship is valid and ready to be placed
 
-    existShip.push_back(shipId);
-    char symbol = m_game.shipSymbol(shipId);
-    if (dir == HORIZONTAL) // place horizontally
-    {
-        for (int c = 0; c < length; c++)
-            m_board[topOrLeft.r][topOrLeft.c + c] = symbol;
-    }
-    else // place vertically
-    {
-        for (int r = 0; r < length; r++)
-            m_board[topOrLeft.r + r][topOrLeft.c] = symbol;
-    }
+    for (int i = 0; i < length; i++)
+        m_grid[first + i * step] = shipId;
+    setPlaced(shipId, true);
+    m_hitsLeft[shipId] = length;
+    m_shipsLeft++;
+    m_shipPos[shipId] = topOrLeft;
+    m_shipDir[shipId] = dir;
     return true;
 }
 
-bool BoardImpl::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+bool BoardImpl::unplaceShip(Cell topOrLeft, int shipId, Direction dir)
 {
-    bool exist = false;
-    size_t i;
     if (shipId < 0 || shipId >= m_game.nShips()) // shipId outside range of ships
         return false;
-
-    for (i = 0; i < existShip.size(); i++) // check is shipId match registered shipId
-    {
-        if (shipId == existShip[i]) // make exist to true and erase the ship
-        {
-            exist = true;
-            break;
-        }
-    }
-    if (!exist)
+    if (!isPlaced(shipId))
         return false;
 
     int length = m_game.shipLength(shipId);
-    char symbol = m_game.shipSymbol(shipId);
-
-    if (dir == HORIZONTAL)
-    {
-        for (int p = 0; p < length; p++) // if some of the symbol in cell of ship not equal to symbol
-        {
-            if (m_board[topOrLeft.r][topOrLeft.c + p] != symbol)
-                return false;
-        }
-        for (int p = 0; p < length; p++) // change all symbol at cell of ship to clear
-        {
-            m_board[topOrLeft.r][topOrLeft.c + p] = '.';
-        }
-    }
-    else
+    if (length != m_hitsLeft[shipId]) // a ship that has been hit stays put
+        return false;
+    if (!m_cells.fits(topOrLeft, length, dir))
+        return false;
+    const int first = topOrLeft;
+    const int step = m_cells.step(dir == HORIZONTAL ? EAST : SOUTH);
+    for (int i = 0; i < length; i++) // if some cell of the ship isn't this ship
     {
-        for (int p = 0; p < length; p++) // if some of the symbol in cell of ship not equal to symbol
-        {
-            if (m_board[topOrLeft.r + p][topOrLeft.c] != symbol)
-                return false;
-        }
-        for (int p = 0; p < length; p++) // change all symbol at cell of ship to clear
-        {
-            m_board[topOrLeft.r + p][topOrLeft.c] = '.';
-        }
+        if (m_grid[first + i * step] != shipId)
+            return false;
     }
+    for (int i = 0; i < length; i++) // change all cells of the ship to clear
+        m_grid[first + i * step] = EMPTY;
 
-    existShip.erase(existShip.begin() + i);
+    setPlaced(shipId, false);
+    m_shipsLeft--;
     return true;
 }
 
 void BoardImpl::display(bool shotsOnly) const
 {
-    if (shotsOnly)
-    {
-        cout << "  ";
-        for (int c = 0; c < m_game.cols(); c++)
-            cout << c;
-        cout << endl;
-
-        for (int r = 0; r < m_game.rows(); r++)
-        {
-            cout << r << " ";
-            for (int c = 0; c < m_game.cols(); c++)
-            {
-                char curr = m_board[r][c];
-                if (curr == 'X' || curr == 'o') // only display shot hit and miss
-                    cout << curr;
-                else // ignore the ship symbol
-                    cout << '.';
-            }
-            cout << endl;
-        }
-    }
-    else
-    {
-        cout << "  ";
-        for (int c = 0; c < m_game.cols(); c++)
-            cout << c;
-        cout << endl;
+    cout << "  ";
+    for (int c = 0; c < m_game.cols(); c++)
+        cout << c;
+    cout << endl;
 
-        for (int r = 0; r < m_game.rows(); r++)
-        {
-            cout << r << " ";
-            for (int c = 0; c < m_game.cols(); c++) // display everything
-            {
-                cout << m_board[r][c];
-            }
-            cout << endl;
-        }
-    }
-}
-
-// helper function
-// if symbol not exist on board, the ship is destroyed
-bool BoardImpl::check(char sym)
-{
     for (int r = 0; r < m_game.rows(); r++)
     {
+        cout << r << " ";
         for (int c = 0; c < m_game.cols(); c++)
         {
-            if (m_board[r][c] == sym)
-                return false;
+            int cell = r * m_game.cols() + c;
+            int curr = m_grid[cell];
+            if (m_shot[cell]) // show hits and misses
+                cout << (curr >= 0 ? 'X' : 'o');
+            else if (curr == BLOCKED)
+                cout << 'X';
+            else if (!shotsOnly && curr >= 0) // and ships unless they're hidden
+                cout << m_game.shipSymbol(curr);
+            else
+                cout << '.';
         }
+        cout << endl;
     }
-    return true;
 }
 
-bool BoardImpl::attack(Point p, bool &shotHit, bool &shipDestroyed, int &shipId)
+bool BoardImpl::attack(Cell cell, bool &shotHit, bool &shipDestroyed, int &shipId)
 {
+    shotHit = false;
     shipDestroyed = false;
-    char curr = m_board[p.r][p.c];
 
-    if (p.r < 0 || p.r >= m_game.rows() || p.c < 0 || p.c >= m_game.cols()) // check point is outside the board
+    if (!m_cells.isValid(cell)) // check cell is outside the board
         return false;
-    if (curr == 'X' || curr == 'o') // check cell attacked before
+    const int curr = m_grid[cell];
+    if (m_shot[cell] || curr == BLOCKED) // check cell attacked before
         return false;
 
-    shotHit = false;
-    size_t i;
-    for (i = 0; i < existShip.size(); i++)
+    m_shot[cell] = true;
+    shotHit = curr >= 0;
+    if (!shotHit)
+        return true;
+
+    shipId = curr;
+    if (--m_hitsLeft[curr] == 0) // the last cell of the ship was hit
     {
-        if (curr == m_game.shipSymbol(existShip[i])) // if the cell is some symbol of exist ship
-        {
-            shotHit = true;
-            break;
-        }
+        shipDestroyed = true;
+        m_shipsLeft--;
     }
+    return true;
+}
 
-    if (!shotHit)
+int BoardImpl::attackBatch(const vector<Cell> &shots, vector<ShotResult> &results)
+{
+    const int n = shots.size();
+    results.resize(n);
+    int hits = 0;
+    for (int i = 0; i < n; i++)
     {
-        m_board[p.r][p.c] = 'o';
-        return true;
+        const Cell cell = shots[i];
+        ShotResult &res = results[i];
+        res.hit = res.destroyed = false;
+        res.valid = m_cells.isValid(cell) && !m_shot[cell] && m_grid[cell] != BLOCKED;
+        if (!res.valid)
+            continue;
+        m_shot[cell] = true;
+        const int curr = m_grid[cell];
+        if (curr < 0)
+            continue;
+        res.hit = true;
+        res.shipId = curr;
+        hits++;
+        if (--m_hitsLeft[curr] == 0) // the last cell of the ship was hit
+        {
+            res.destroyed = true;
+            m_shipsLeft--;
+        }
     }
+    return hits;
+}
 
-    m_board[p.r][p.c] = 'X';
+int BoardImpl::attackBatch(const vector<Point> &shots, vector<ShotResult> &results)
+{
+    m_batch.clear();
+    for (const Point &p : shots)
+        m_batch.push_back(m_cells.cellOf(p));
+    return attackBatch(m_batch, results);
+}
 
-    shipDestroyed = check(curr);
+bool BoardImpl::allShipsDestroyed() const
+{
+    return m_shipsLeft == 0;
+}
 
-    if (shipDestroyed) // if ship destroyed erase it from exist ship
+bool BoardImpl::copyShipsTo(GameState &state, int s) const
+{
+    for (int shipId = 0; shipId < m_game.nShips(); shipId++)
     {
-        shipId = existShip[i];
-        existShip.erase(existShip.begin() + i);
+        if (isPlaced(shipId) && m_hitsLeft[shipId] > 0 &&
+            !state.placeShip(s, m_cells.pointOf(m_shipPos[shipId]), shipId, m_game.shipLength(shipId), m_shipDir[shipId]))
+            return false;
     }
     return true;
 }
 
-bool BoardImpl::allShipsDestroyed() const
+bool BoardImpl::findShip(int shipId, Point &topOrLeft, Direction &dir) const
 {
-    return existShip.empty(); // exist ship is empty if all ship destroyed
+    if (shipId < 0 || shipId >= m_game.nShips() || !isPlaced(shipId))
+        return false;
+    topOrLeft = m_cells.pointOf(m_shipPos[shipId]);
+    dir = m_shipDir[shipId];
+    return true;
 }
 
 //******************** Board functions ********************************
@@ -309,11 +296,21 @@ void Board::unblock()
 }
 
 bool Board::placeShip(Point topOrLeft, int shipId, Direction dir)
+{
+    return m_impl->placeShip(m_impl->cellOf(topOrLeft), shipId, dir);
+}
+
+bool Board::placeShip(Cell topOrLeft, int shipId, Direction dir)
 {
     return m_impl->placeShip(topOrLeft, shipId, dir);
 }
 
 bool Board::unplaceShip(Point topOrLeft, int shipId, Direction dir)
+{
+    return m_impl->unplaceShip(m_impl->cellOf(topOrLeft), shipId, dir);
+}
+
+bool Board::unplaceShip(Cell topOrLeft, int shipId, Direction dir)
 {
     return m_impl->unplaceShip(topOrLeft, shipId, dir);
 }
@@ -325,10 +322,40 @@ void Board::display(bool shotsOnly) const
 
 bool Board::attack(Point p, bool &shotHit, bool &shipDestroyed, int &shipId)
 {
-    return m_impl->attack(p, shotHit, shipDestroyed, shipId);
+    return m_impl->attack(m_impl->cellOf(p), shotHit, shipDestroyed, shipId);
+}
+
+bool Board::attack(Cell cell, bool &shotHit, bool &shipDestroyed, int &shipId)
+{
+    return m_impl->attack(cell, shotHit, shipDestroyed, shipId);
+}
+
+int Board::attackBatch(const vector<Point> &shots, vector<ShotResult> &results)
+{
+    return m_impl->attackBatch(shots, results);
+}
+
+int Board::attackBatch(const vector<Cell> &shots, vector<ShotResult> &results)
+{
+    return m_impl->attackBatch(shots, results);
 }
 
 bool Board::allShipsDestroyed() const
 {
     return m_impl->allShipsDestroyed();
+}
+
+int Board::shipsLeft() const
+{
+    return m_impl->shipsLeft();
+}
+
+bool Board::copyShipsTo(GameState &state, int s) const
+{
+    return m_impl->copyShipsTo(state, s);
+}
+
+bool Board::findShip(int shipId, Point &topOrLeft, Direction &dir) const
+{
+    return m_impl->findShip(shipId, topOrLeft, dir);
 }
\ No newline at end of file
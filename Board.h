@@ -2,8 +2,10 @@
 #define BOARD_INCLUDED
 
 #include "globals.h"
+#include <vector>
 
 class Game;
+class GameState;
 class BoardImpl;
 
 class Board
@@ -17,8 +19,27 @@ class Board
     bool placeShip(Point topOrLeft, int shipId, Direction dir);
     bool unplaceShip(Point topOrLeft, int shipId, Direction dir);
     void display(bool shotsOnly) const;
+      // Return false for a wasted shot.  shotHit and shipDestroyed are
+      // always set, and shipId only on a hit, exactly as GameState::attack
+      // sets them.
     bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId);
+      // The same, with cells numbered as in the game's CellGrid
+    bool placeShip(Cell topOrLeft, int shipId, Direction dir);
+    bool unplaceShip(Cell topOrLeft, int shipId, Direction dir);
+    bool attack(Cell cell, bool& shotHit, bool& shipDestroyed, int& shipId);
+      // Attack every shot of a salvo in one pass, in order, replacing results
+      // with what became of each; return how many hit.  A cell fired at twice
+      // in a salvo is a wasted shot the second time.
+    int attackBatch(const std::vector<Point>& shots, std::vector<ShotResult>& results);
+    int attackBatch(const std::vector<Cell>& shots, std::vector<ShotResult>& results);
     bool allShipsDestroyed() const;
+      // The placed ships not yet destroyed
+    int shipsLeft() const;
+      // Place the ships on this board onto side s of a game state
+    bool copyShipsTo(GameState& state, int s) const;
+      // Set topOrLeft and dir to where ship shipId is; return false if it
+      // isn't on the board
+    bool findShip(int shipId, Point& topOrLeft, Direction& dir) const;
       // We prevent a Board object from being copied or assigned
     Board(const Board&) = delete;
     Board& operator=(const Board&) = delete;
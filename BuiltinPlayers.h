@@ -0,0 +1,108 @@
+#ifndef BUILTINPLAYERS_INCLUDED
+#define BUILTINPLAYERS_INCLUDED
+
+#include "CellGrid.h"
+#include "Player.h"
+#include "globals.h"
+#include <string>
+#include <vector>
+
+class FleetSampler;
+
+  // The computer players createPlayer makes for "awful", "mediocre" and
+  // "good".  They are final, so code that knows it holds one of them, like
+  // Game::playStatic, calls their functions directly instead of through the
+  // vtable, and the empty ones below inline away entirely.  The rest are in
+  // Player.cpp, so they inline into the turn loop only in a build with link
+  // time optimization, as in the README.
+
+class AwfulPlayer final : public Player
+{
+  public:
+    AwfulPlayer(std::string nm, const Game& g);
+    bool placeShips(Board& b) override;
+    Point recommendAttack() override;
+      // AwfulPlayer completely ignores the result of any attack
+    void recordAttackResult(Point /* p */, bool /* validShot */, bool /* shotHit */,
+                            bool /* shipDestroyed */, int /* shipId */) override {}
+      // AwfulPlayer completely ignores what the opponent does
+    void recordAttackByOpponent(Point /* p */) override {}
+      // AwfulPlayer walks the board backwards a cell at a time
+    bool attacksByCell() const override { return true; }
+    int recommendAttackCell() override
+    {
+        m_lastCellAttacked = (m_lastCellAttacked > 0 ? m_lastCellAttacked : m_cells.nCells()) - 1;
+        return m_lastCellAttacked;
+    }
+    void recordAttackResultAt(int /* cell */, bool /* validShot */, bool /* shotHit */,
+                              bool /* shipDestroyed */, int /* shipId */) override {}
+    void recordAttackByOpponentAt(int /* cell */) override {}
+    void recommendAttacks(int k, std::vector<Point>& shots) override;
+    void recordAttackResults(const std::vector<Point>& /* shots */,
+                             const std::vector<ShotResult>& /* results */) override {}
+
+  private:
+    const CellGrid& m_cells;
+    Cell m_lastCellAttacked;
+};
+
+class MediocrePlayer final : public Player
+{
+  public:
+      // MediocrePlayer gives up placing its ships after placementTries tries
+    MediocrePlayer(std::string nm, const Game& g, int placementTries);
+    bool placeShips(Board& b) override;
+    Point recommendAttack() override;
+    void recordAttackResult(Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId) override;
+    void recordAttackByOpponent(Point /* p */) override {}
+
+  private:
+    bool place(int k, int total, Board& b);
+    int m_placementTries;
+    std::vector<Point> CellNotDiscovered;
+    std::vector<Point> cellToHit;
+    Point m_shipCell;
+    bool m_shotHit;
+    bool m_shipDestroyed;
+    bool m_state;
+};
+
+class GoodPlayer final : public Player
+{
+  public:
+      // After a hit, GoodPlayer probes up to probeRadius - 1 cells each way
+      // for the rest of the ship, and goes back to searching if more than
+      // overflowGuard cells are waiting to be probed
+    GoodPlayer(std::string nm, const Game& g, int probeRadius, int overflowGuard);
+    bool placeShips(Board& b) override;
+    Point recommendAttack() override;
+    void recordAttackResult(Point p, bool validShot, bool shotHit,
+                            bool shipDestroyed, int shipId) override;
+    void recordAttackByOpponent(Point /* p */) override {}
+
+  private:
+    bool place(int k, int total, Board& b);
+      // The turns on the game's shape, StandardGame or RuntimeGame (see
+      // FixedGame.h), so the standard game's bounds and ship lengths are constants
+    template <class Shape>
+    Point recommendAttackOn(const Shape& shape);
+    template <class Shape>
+    void recordAttackResultOn(const Shape& shape, Point p, bool validShot, bool shotHit,
+                              bool shipDestroyed, int shipId);
+    int m_probeRadius;
+    int m_overflowGuard;
+    Point m_shipCell;
+    bool m_shotHit;
+    bool m_shipDestroyed;
+    bool m_state;
+    Point toCheck;
+    int shortestShip;
+    const FleetSampler& m_sampler; // the game's shared sampler, looked up once
+    bool m_standard;               // the game is a StandardGame
+    std::vector<int> shipIdDestroyed;
+    std::vector<Point> CellNotDiscovered;
+    std::vector<Point> ship;
+};
+
+#endif // BUILTINPLAYERS_INCLUDED
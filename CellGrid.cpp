@@ -0,0 +1,36 @@
+#include "CellGrid.h"
+#include "globals.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+CellGrid::CellGrid(int nRows, int nCols)
+    : m_rows(nRows), m_cols(nCols), m_nCells(nRows * nCols), m_step{-nCols, 1, nCols, -1},
+      m_reach(4 * nRows * nCols)
+{
+    static_assert(MAXROWS <= 65536 && MAXCOLS <= 65536, "reaches are stored in 16 bits");
+    for (int r = 0; r < nRows; r++)
+        for (int c = 0; c < nCols; c++)
+        {
+            uint16_t *reach = &m_reach[4 * (r * nCols + c)];
+            reach[NORTH] = r;
+            reach[EAST] = nCols - 1 - c;
+            reach[SOUTH] = nRows - 1 - r;
+            reach[WEST] = c;
+        }
+}
+
+const CellGrid &CellGrid::shared(int nRows, int nCols)
+{
+    static mutex gridsLock;
+    static map<pair<int, int>, unique_ptr<CellGrid>> grids;
+    lock_guard<mutex> guard(gridsLock);
+    unique_ptr<CellGrid> &grid = grids[make_pair(nRows, nCols)];
+    if (!grid)
+        grid.reset(new CellGrid(nRows, nCols));
+    return *grid;
+}
@@ -0,0 +1,55 @@
+#ifndef CELLGRID_INCLUDED
+#define CELLGRID_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+#include <vector>
+
+  // The cells of a board with nRows rows and nCols columns, numbered row by
+  // row, and a table of how far each cell is from the edge in each heading.
+  // The ray from cell c heading h is the reach(c, h) cells
+  // c + step(h), c + 2 * step(h), ..., so neighbors, ship spans and lines of
+  // fire are table lookups and index arithmetic with no 2D bounds checks.
+class CellGrid
+{
+  public:
+    CellGrid(int nRows, int nCols);
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int nCells() const { return m_nCells; }
+    bool isValid(Cell cell) const { return unsigned(cell) < unsigned(m_nCells); }
+      // NOCELL if p is off the board
+    Cell cellOf(Point p) const
+    {
+        return unsigned(p.r) < unsigned(m_rows) && unsigned(p.c) < unsigned(m_cols)
+                   ? p.r * m_cols + p.c : NOCELL;
+    }
+    Point pointOf(Cell cell) const { return Point(cell / m_cols, cell % m_cols); }
+      // How much a cell index changes moving one cell in heading h
+    int step(Heading h) const { return m_step[h]; }
+      // The number of cells beyond cell before the edge in heading h
+    int reach(Cell cell, Heading h) const { return m_reach[4 * cell + h]; }
+      // The adjacent cell in heading h, or NOCELL at the edge
+    Cell neighbor(Cell cell, Heading h) const
+    {
+        return m_reach[4 * cell + h] != 0 ? cell + m_step[h] : NOCELL;
+    }
+      // Return true if a ship of length cells fits on the board starting at
+      // cell and running right or down
+    bool fits(Cell cell, int length, Direction dir) const
+    {
+        return isValid(cell) && reach(cell, dir == HORIZONTAL ? EAST : SOUTH) >= length - 1;
+    }
+      // Return a grid for boards of this size that is shared by every game
+      // of that size and kept until the program ends
+    static const CellGrid& shared(int nRows, int nCols);
+
+  private:
+    int m_rows;
+    int m_cols;
+    int m_nCells;
+    int m_step[4];
+    std::vector<uint16_t> m_reach; // 4 per cell, by heading
+};
+
+#endif // CELLGRID_INCLUDED
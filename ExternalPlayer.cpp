@@ -0,0 +1,243 @@
+#include "Player.h"
+#include "Board.h"
+#include "Game.h"
+#include "globals.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+//*********************************************************************
+//  ExternalPlayer
+//*********************************************************************
+
+// An ExternalPlayer is a bot running outside this program.  We either start
+// it as a child process whose stdin and stdout are one end of a Unix socket
+// pair, or, for "unix:<path>", connect to a bot already listening on a Unix
+// socket.  Every message is an opcode byte followed by little-endian 16-bit
+// signed integers:
+//
+//   host -> bot
+//     'G' rows cols nShips length...    once, before anything else
+//     'P'                               bot replies nShips x (r c dir), dir 0 = h, 1 = v
+//     'A'                               bot replies (r c) to attack
+//     'R' r c flags shipId              flags: 1 valid shot, 2 hit, 4 destroyed
+//     'O' r c                           the opponent attacked (r, c)
+//     'Q'                               the game is over; the bot should exit
+//
+// 'R' and 'O' have no reply, so we hold them back and send them in the same
+// write as the next 'A'.  A turn costs one write and one read.
+//
+// A bot that takes more than REPLY_SECONDS to answer, or that goes away, is
+// dead: it is sent nothing more and forfeits the game.
+
+// How long a bot may take over one reply
+const int REPLY_SECONDS = 30;
+
+class ExternalPlayer : public Player
+{
+public:
+    ExternalPlayer(string nm, const Game &g, int fd, pid_t pid);
+    virtual ~ExternalPlayer();
+    virtual bool placeShips(Board &b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual bool hasForfeited() const { return m_dead; }
+
+private:
+    void put(int value);
+    bool flush();
+    bool receive(short *values, int n);
+    int m_fd;
+    pid_t m_pid;
+    bool m_dead; // the bot stopped answering
+    vector<unsigned char> m_out; // messages not yet sent
+};
+
+ExternalPlayer::ExternalPlayer(string nm, const Game &g, int fd, pid_t pid)
+    : Player(nm, g), m_fd(fd), m_pid(pid), m_dead(false)
+{
+    // a bot that stops reading can't block a send for longer than a reply
+    timeval timeout{REPLY_SECONDS, 0};
+    setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    m_out.reserve(64 + 2 * g.nShips());
+    m_out.push_back('G');
+    put(g.rows());
+    put(g.cols());
+    put(g.nShips());
+    for (int k = 0; k < g.nShips(); k++)
+        put(g.shipLength(k));
+    flush();
+}
+
+ExternalPlayer::~ExternalPlayer()
+{
+    m_out.push_back('Q');
+    flush();
+    close(m_fd);
+    if (m_pid > 0)
+    {
+        // give a live bot a moment to exit on its own before we insist
+        for (int i = 0; i < 100 && !m_dead && waitpid(m_pid, nullptr, WNOHANG) == 0; i++)
+            usleep(1000);
+        if (waitpid(m_pid, nullptr, WNOHANG) == 0)
+        {
+            kill(m_pid, SIGKILL);
+            waitpid(m_pid, nullptr, 0);
+        }
+    }
+}
+
+// helper function
+// queue a 16-bit value
+void ExternalPlayer::put(int value)
+{
+    m_out.push_back(value & 0xff);
+    m_out.push_back((value >> 8) & 0xff);
+}
+
+// helper function
+// send everything queued; return false if the bot is dead
+bool ExternalPlayer::flush()
+{
+    size_t sent = 0;
+    while (!m_dead && sent < m_out.size())
+    {
+        // MSG_NOSIGNAL so a dead bot doesn't kill us with SIGPIPE
+        ssize_t n = send(m_fd, m_out.data() + sent, m_out.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            m_dead = true;
+        else
+            sent += n;
+    }
+    m_out.clear();
+    return !m_dead;
+}
+
+// helper function
+// read n (at most 3) 16-bit values from the bot; return false if the bot
+// is dead or doesn't send them within REPLY_SECONDS
+bool ExternalPlayer::receive(short *values, int n)
+{
+    unsigned char in[6];
+    size_t got = 0;
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(REPLY_SECONDS);
+    while (!m_dead && got < size_t(n * 2))
+    {
+        auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+        pollfd ready{m_fd, POLLIN, 0};
+        int polled = left.count() > 0 ? poll(&ready, 1, left.count()) : 0;
+        if (polled < 0 && errno == EINTR)
+            continue;
+        ssize_t r = polled > 0 ? recv(m_fd, in + got, n * 2 - got, 0) : 0;
+        if (r <= 0)
+            m_dead = true; // it went away, or is too slow to trust with the rest of the game
+        else
+            got += r;
+    }
+    if (m_dead)
+        return false;
+    for (int i = 0; i < n; i++)
+        values[i] = short(in[2 * i] | (in[2 * i + 1] << 8));
+    return true;
+}
+
+bool ExternalPlayer::placeShips(Board &b)
+{
+    m_out.push_back('P');
+    if (!flush())
+        return false;
+    for (int k = 0; k < game().nShips(); k++)
+    {
+        short ship[3];
+        if (!receive(ship, 3))
+            return false;
+        if (!b.placeShip(Point(ship[0], ship[1]), k, ship[2] == 0 ? HORIZONTAL : VERTICAL))
+            return false;
+    }
+    return true;
+}
+
+Point ExternalPlayer::recommendAttack()
+{
+    m_out.push_back('A');
+    short cell[2];
+    if (!flush() || !receive(cell, 2))
+        return Point(-1, -1); // a dead bot wastes the shot, then forfeits
+    return Point(cell[0], cell[1]);
+}
+
+void ExternalPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                        bool shipDestroyed, int shipId)
+{
+    m_out.push_back('R');
+    put(p.r);
+    put(p.c);
+    put((validShot ? 1 : 0) | (shotHit ? 2 : 0) | (shipDestroyed ? 4 : 0));
+    put(shipDestroyed ? shipId : -1);
+}
+
+void ExternalPlayer::recordAttackByOpponent(Point p)
+{
+    m_out.push_back('O');
+    put(p.r);
+    put(p.c);
+}
+
+Player *createExternalPlayer(const string &command, string nm, const Game &g)
+{
+    if (command.compare(0, 5, "unix:") == 0) // connect to a bot that is already running
+    {
+        string path = command.substr(5);
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+            return nullptr;
+        strcpy(addr.sun_path, path.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+            return nullptr;
+        if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+        return new ExternalPlayer(nm, g, fd, -1);
+    }
+
+    if (command.empty())
+        return nullptr;
+    string shellCommand = "exec " + command; // the bot replaces the shell
+    int fds[2];
+    // close-on-exec, so bots started by other threads don't inherit this one's socket
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        return nullptr;
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return nullptr;
+    }
+    if (pid == 0)
+    {
+        dup2(fds[1], STDIN_FILENO);
+        dup2(fds[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", shellCommand.c_str(), static_cast<char *>(nullptr));
+        _exit(127);
+    }
+    close(fds[1]);
+    return new ExternalPlayer(nm, g, fds[0], pid);
+}
@@ -0,0 +1,112 @@
+#ifndef FIXEDGAME_INCLUDED
+#define FIXEDGAME_INCLUDED
+
+#include "Game.h"
+#include "globals.h"
+
+  // The five ships of the standard game, the fleet main.cpp plays with
+struct StandardFleet
+{
+    static constexpr int nShips = 5;
+    static constexpr int lengths[nShips] = {5, 4, 3, 3, 2};
+    static constexpr char symbols[nShips] = {'A', 'B', 'D', 'S', 'P'};
+    static constexpr const char* names[nShips] = {
+        "aircraft carrier", "battleship", "destroyer", "submarine", "patrol boat"};
+};
+
+  // The shape of a game whose board and fleet are fixed at compile time; a
+  // Fleet is a type like StandardFleet.  It is not a Game, which stays the
+  // general path.  The turn loop in Game.cpp, GoodPlayer's turns and
+  // MctsPlayer's search are templated on a shape, this or RuntimeGame, so on
+  // a matching game their cell and point conversions, board bounds and ship
+  // lengths are constants.  Code checks matches() before taking that path.
+template <int R, int C, class Fleet>
+class FixedGame
+{
+  public:
+    static_assert(R >= 1 && R <= MAXROWS && C >= 1 && C <= MAXCOLS, "no such board");
+    static constexpr int rows() { return R; }
+    static constexpr int cols() { return C; }
+    static constexpr int nCells() { return R * C; }
+    static constexpr int nShips() { return Fleet::nShips; }
+    static constexpr int shipLength(int shipId) { return Fleet::lengths[shipId]; }
+    static constexpr int longestShip()
+    {
+        int longest = 0;
+        for (int k = 0; k < Fleet::nShips; k++)
+            longest = Fleet::lengths[k] > longest ? Fleet::lengths[k] : longest;
+        return longest;
+    }
+    static constexpr int shortestShip()
+    {
+        int shortest = MAXROWS;
+        for (int k = 0; k < Fleet::nShips; k++)
+            shortest = Fleet::lengths[k] < shortest ? Fleet::lengths[k] : shortest;
+        return shortest;
+    }
+    static constexpr int totalLength()
+    {
+        int total = 0;
+        for (int k = 0; k < Fleet::nShips; k++)
+            total += Fleet::lengths[k];
+        return total;
+    }
+    static constexpr int rowOf(Cell cell) { return cell / C; }
+    static constexpr int colOf(Cell cell) { return cell % C; }
+    static constexpr bool isValid(Cell cell) { return unsigned(cell) < unsigned(R * C); }
+      // NOCELL if p is off the board, as CellGrid::cellOf
+    static Cell cellOf(Point p)
+    {
+        return unsigned(p.r) < unsigned(R) && unsigned(p.c) < unsigned(C) ? p.r * C + p.c : NOCELL;
+    }
+    static Point pointOf(Cell cell) { return Point(cell / C, cell % C); }
+      // Add the fleet to g, which should be R by C and have no ships yet
+    static bool addShips(Game& g)
+    {
+        for (int k = 0; k < Fleet::nShips; k++)
+            if (!g.addShip(Fleet::lengths[k], Fleet::symbols[k], Fleet::names[k]))
+                return false;
+        return true;
+    }
+      // Return true if g has this board and ships of these lengths, in order
+    static bool matches(const Game& g)
+    {
+        if (g.rows() != R || g.cols() != C || g.nShips() != Fleet::nShips)
+            return false;
+        for (int k = 0; k < Fleet::nShips; k++)
+            if (g.shipLength(k) != Fleet::lengths[k])
+                return false;
+        return true;
+    }
+};
+
+typedef FixedGame<10, 10, StandardFleet> StandardGame;
+static_assert(StandardGame::totalLength() == 17, "the standard fleet covers 17 cells");
+
+  // The same questions answered at runtime for any game, for the search to
+  // use when the game is not a FixedGame
+class RuntimeGame
+{
+  public:
+    RuntimeGame(const Game& g) : m_game(g), m_rows(g.rows()), m_cols(g.cols()) {}
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int nCells() const { return m_rows * m_cols; }
+    int nShips() const { return m_game.nShips(); }
+    int shipLength(int shipId) const { return m_game.shipLength(shipId); }
+    int rowOf(Cell cell) const { return cell / m_cols; }
+    int colOf(Cell cell) const { return cell % m_cols; }
+    bool isValid(Cell cell) const { return unsigned(cell) < unsigned(m_rows * m_cols); }
+    Cell cellOf(Point p) const
+    {
+        return unsigned(p.r) < unsigned(m_rows) && unsigned(p.c) < unsigned(m_cols) ? p.r * m_cols + p.c : NOCELL;
+    }
+    Point pointOf(Cell cell) const { return Point(cell / m_cols, cell % m_cols); }
+
+  private:
+    const Game& m_game;
+    int m_rows;
+    int m_cols;
+};
+
+#endif // FIXEDGAME_INCLUDED
@@ -0,0 +1,435 @@
+#include "FleetSampler.h"
+#include "Board.h"
+#include "Game.h"
+#include "Trace.h"
+#include "globals.h"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// The sampler counts layouts by scanning the board a row at a time.  Before
+// each cell, a state says which cells ahead of the scan are already covered
+// and how many ships of each length have been placed.  A ship covers cells
+// ahead of the scan only in its own row or column, so it is enough to know,
+// for every column, how many of its next cells are covered.  The states of
+// the scan form a graph whose edges are the choices at a cell: leave it
+// empty, or start a ship of some length there going right or down.
+// Counting, from the last cell back, how many finished layouts each state
+// leads to lets a draw take each edge with probability proportional to the
+// layouts behind it, which makes every layout equally likely.  Ships of
+// equal length are interchangeable while scanning, so a drawn layout hands
+// their ids out in random order at the end.
+//
+// The graph grows with the number of ways ships can stick out past the scan,
+// and already has millions of states for the standard fleet on a 10 x 10
+// board.  When it would be too big, a draw instead places every ship in one
+// of its own positions picked uniformly and starts over if two ships overlap.
+// Each layout is still equally likely, and for the standard fleet about two
+// draws in five succeed.
+
+class FleetSamplerImpl
+{
+public:
+    FleetSamplerImpl(const Game &g, const vector<Point> &blocked);
+    bool countsLayouts() const { return m_counted; }
+    double nLayouts() const;
+    bool sample(vector<ShipPlacement> &layout) const;
+    bool placeShips(Board &b) const;
+
+private:
+    // An edge holds what a draw needs of the state it leads to, so a draw
+    // reads one run of edges per cell
+    struct Edge
+    {
+        uint64_t completions; // layouts that can be finished from the state
+        uint32_t first;       // where the state's edges start
+        uint8_t nEdges;
+        int8_t group;         // the length group of the ship started here, or -1
+        uint8_t dir;
+    };
+    struct Spot
+    {
+        ShipPlacement where;
+        int first; // the cells are first, first + step, ...
+        int step;
+    };
+    static const size_t MAXLAYER = 1 << 14; // most states before one cell
+    static const size_t MAXNODES = 1 << 19;
+    static const int MAXGROUPS = 32;
+    static const int MAXATTEMPTS = 10000; // draws to try when not counting
+    bool build(const vector<bool> &blocked);
+    bool sampleCounted(vector<ShipPlacement> &layout) const;
+    bool sampleByRetrying(vector<ShipPlacement> &layout) const;
+    int m_rows;
+    int m_cols;
+    int m_nShips;
+    int m_bits;                     // bits per column in a key
+    vector<int> m_groupLength;      // the distinct ship lengths
+    vector<int> m_groupCount;       // how many ships have each length
+    vector<vector<int>> m_groupIds; // and their ids
+    vector<uint64_t> m_radix;       // place value of each group's count in a key
+    double m_labelings;             // ways to hand out ids among equal lengths
+    bool m_counted;
+    Edge m_start;                   // leads to the state before the first cell
+    vector<Edge> m_edges;
+    vector<vector<Spot>> m_spots;   // per group, positions clear of blocked cells
+    vector<int> m_groupOf;          // per ship id
+};
+
+FleetSamplerImpl::FleetSamplerImpl(const Game &g, const vector<Point> &blocked)
+    : m_rows(g.rows()), m_cols(g.cols()), m_nShips(g.nShips()), m_bits(1), m_labelings(1), m_counted(false),
+      m_groupOf(g.nShips())
+{
+    map<int, vector<int>> byLength;
+    for (int k = 0; k < m_nShips; k++)
+        byLength[g.shipLength(k)].push_back(k);
+    for (const auto &group : byLength)
+    {
+        m_groupLength.push_back(group.first);
+        m_groupCount.push_back(group.second.size());
+        m_groupIds.push_back(group.second);
+        for (int k : group.second)
+            m_groupOf[k] = m_groupLength.size() - 1;
+        for (int i = 2; i <= int(group.second.size()); i++)
+            m_labelings *= i;
+    }
+    while (!m_groupLength.empty() && (1 << m_bits) < m_groupLength.back()) // room for up to length - 1 covered cells
+        m_bits++;
+
+    vector<bool> isBlocked(m_rows * m_cols);
+    for (Point p : blocked)
+        if (g.isValid(p))
+            isBlocked[p.r * m_cols + p.c] = true;
+    m_counted = build(isBlocked);
+    if (m_counted)
+        return;
+    m_edges.clear();
+    m_edges.shrink_to_fit();
+
+    // too many to count, so list where each length can go for drawing by retrying
+    for (int len : m_groupLength)
+    {
+        m_spots.push_back(vector<Spot>());
+        for (int r = 0; r < m_rows; r++)
+        {
+            for (int c = 0; c < m_cols; c++)
+            {
+                for (Direction dir : {HORIZONTAL, VERTICAL})
+                {
+                    if ((dir == HORIZONTAL && c + len > m_cols) || (dir == VERTICAL && r + len > m_rows))
+                        continue;
+                    if (len == 1 && dir == VERTICAL) // a one cell ship only needs one direction
+                        continue;
+                    Spot spot{ShipPlacement{Point(r, c), dir}, r * m_cols + c, dir == HORIZONTAL ? 1 : m_cols};
+                    bool clear = true;
+                    for (int i = 0; i < len; i++)
+                        clear = clear && !isBlocked[spot.first + i * spot.step];
+                    if (clear)
+                        m_spots.back().push_back(spot);
+                }
+            }
+        }
+    }
+}
+
+// helper function
+// build the graph of scan states and count completions; return false if the
+// keys or the graph would be too big
+bool FleetSamplerImpl::build(const vector<bool> &blocked)
+{
+    // a key is the covered counts of every column, then each group's count placed
+    int profileBits = m_cols * m_bits;
+    uint64_t fleetStates = 1;
+    for (int count : m_groupCount)
+    {
+        m_radix.push_back(fleetStates);
+        fleetStates *= count + 1;
+        if (profileBits >= 64 || fleetStates > (uint64_t(1) << (63 - profileBits)))
+            return false;
+    }
+    if (m_groupLength.size() > size_t(MAXGROUPS))
+        return false;
+    const uint64_t columnMask = (uint64_t(1) << m_bits) - 1;
+    const uint64_t profileMask = (uint64_t(1) << profileBits) - 1;
+    const int nCells = m_rows * m_cols;
+    int shipCells = 0;
+    for (size_t gr = 0; gr < m_groupLength.size(); gr++)
+        shipCells += m_groupLength[gr] * m_groupCount[gr];
+
+    // cells still needed by the ships a key hasn't placed, less the covered
+    // cells ahead; a key that needs more than the cells left is a dead end
+    auto stillNeeded = [&](uint64_t key) {
+        int needed = shipCells;
+        uint64_t fleet = key >> profileBits;
+        for (size_t gr = 0; gr < m_groupLength.size(); gr++)
+            needed -= m_groupLength[gr] * int(fleet / m_radix[gr] % (m_groupCount[gr] + 1));
+        for (uint64_t profile = key & profileMask; profile != 0; profile >>= m_bits)
+            needed += int(profile & columnMask);
+        return needed;
+    };
+
+    // the states of each cell follow those of the one before; an edge's
+    // first is the index of the state it leads to until they are counted
+    struct Node
+    {
+        uint64_t completions;
+        uint32_t firstEdge;
+        uint32_t nEdges;
+    };
+    vector<Node> nodes(1, Node{0, 0, 0});
+    vector<uint64_t> layer(1, 0);
+    vector<uint64_t> nextLayer;
+    unordered_map<uint64_t, uint32_t> nextIndex;
+    for (int cell = 0; cell < nCells; cell++)
+    {
+        int r = cell / m_cols, c = cell % m_cols;
+        size_t base = nodes.size() - layer.size();
+        size_t nextBase = nodes.size();
+        nextLayer.clear();
+        nextIndex.clear();
+        auto addEdge = [&](uint64_t key, int group, Direction dir) {
+            if (stillNeeded(key) > nCells - cell - 1)
+                return;
+            auto found = nextIndex.emplace(key, uint32_t(nextLayer.size()));
+            if (found.second)
+                nextLayer.push_back(key);
+            m_edges.push_back(Edge{0, uint32_t(nextBase + found.first->second), 0, int8_t(group), uint8_t(dir)});
+        };
+        for (size_t j = 0; j < layer.size(); j++)
+        {
+            uint64_t key = layer[j];
+            nodes[base + j].firstEdge = m_edges.size();
+            uint64_t covered = (key >> (c * m_bits)) & columnMask;
+            if (covered > 0) // an earlier ship is here
+                addEdge(key - (uint64_t(1) << (c * m_bits)), -1, HORIZONTAL);
+            else
+            {
+                addEdge(key, -1, HORIZONTAL);
+                for (size_t gr = 0; !blocked[cell] && gr < m_groupLength.size(); gr++)
+                {
+                    if (int((key >> profileBits) / m_radix[gr] % (m_groupCount[gr] + 1)) == m_groupCount[gr])
+                        continue;
+                    int len = m_groupLength[gr];
+                    uint64_t placed = key + (m_radix[gr] << profileBits);
+                    bool fits = c + len <= m_cols;
+                    uint64_t across = 0;
+                    for (int i = 1; fits && i < len; i++)
+                    {
+                        fits = !blocked[cell + i] && ((key >> ((c + i) * m_bits)) & columnMask) == 0;
+                        across |= uint64_t(1) << ((c + i) * m_bits);
+                    }
+                    if (fits)
+                        addEdge(placed | across, gr, HORIZONTAL);
+                    if (len == 1) // a one cell ship only needs one direction
+                        continue;
+                    fits = r + len <= m_rows;
+                    for (int i = 1; fits && i < len; i++)
+                        fits = !blocked[cell + i * m_cols];
+                    if (fits)
+                        addEdge(placed | (uint64_t(len - 1) << (c * m_bits)), gr, VERTICAL);
+                }
+            }
+            nodes[base + j].nEdges = m_edges.size() - nodes[base + j].firstEdge;
+        }
+        if (nextLayer.size() > MAXLAYER || nodes.size() + nextLayer.size() > MAXNODES)
+            return false;
+        nodes.resize(nodes.size() + nextLayer.size(), Node{0, 0, 0});
+        layer.swap(nextLayer);
+    }
+
+    // every ship has been placed in a state that survives the last cell
+    size_t lastLayer = nodes.size() - layer.size();
+    for (size_t i = lastLayer; i < nodes.size(); i++)
+        nodes[i].completions = 1;
+    for (size_t i = lastLayer; i-- > 0;) // edges only lead to later states
+    {
+        Node &n = nodes[i];
+        for (uint32_t e = n.firstEdge; e < n.firstEdge + n.nEdges; e++)
+        {
+            uint64_t more = nodes[m_edges[e].first].completions;
+            if (n.completions > UINT64_MAX - more) // too many to count exactly
+                return false;
+            n.completions += more;
+        }
+    }
+
+    // drop the edges into dead ends so a draw never looks at them, then
+    // point every edge at the edges of the state it leads to
+    vector<uint32_t> keptFirst(nodes.size() + 1, 0);
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        keptFirst[i + 1] = keptFirst[i];
+        for (uint32_t e = nodes[i].firstEdge; e < nodes[i].firstEdge + nodes[i].nEdges; e++)
+            keptFirst[i + 1] += nodes[m_edges[e].first].completions > 0;
+    }
+    size_t kept = 0;
+    for (const Node &n : nodes)
+    {
+        for (uint32_t e = n.firstEdge; e < n.firstEdge + n.nEdges; e++)
+        {
+            uint32_t to = m_edges[e].first;
+            if (nodes[to].completions == 0)
+                continue;
+            Edge &edge = m_edges[kept++];
+            edge = m_edges[e];
+            edge.completions = nodes[to].completions;
+            edge.first = keptFirst[to];
+            edge.nEdges = keptFirst[to + 1] - keptFirst[to];
+        }
+    }
+    m_edges.resize(kept);
+    m_edges.shrink_to_fit();
+    m_start = Edge{nodes[0].completions, 0, uint8_t(keptFirst[1]), -1, 0};
+    return true;
+}
+
+double FleetSamplerImpl::nLayouts() const
+{
+    return m_counted ? double(m_start.completions) * m_labelings : 0;
+}
+
+bool FleetSamplerImpl::sample(vector<ShipPlacement> &layout) const
+{
+    TraceSpan span("sampleFleet");
+    layout.resize(m_nShips);
+    return m_counted ? sampleCounted(layout) : sampleByRetrying(layout);
+}
+
+// helper function
+// draw a layout by walking the graph of scan states
+bool FleetSamplerImpl::sampleCounted(vector<ShipPlacement> &layout) const
+{
+    if (m_start.completions == 0)
+        return false;
+    int placed[MAXGROUPS] = {};
+    // number the layouts from 0 and pick one; at each cell, the edges split
+    // the numbers left into ranges as long as their counts of layouts
+    uint64_t pick = randInt64(m_start.completions);
+    const Edge *at = &m_start;
+    for (int r = 0; r < m_rows; r++)
+    {
+        for (int c = 0; c < m_cols; c++)
+        {
+            const Edge *e = &m_edges[at->first];
+            for (; pick >= e->completions; e++)
+                pick -= e->completions;
+            if (e->group >= 0)
+                layout[m_groupIds[e->group][placed[e->group]++]] = ShipPlacement{Point(r, c), Direction(e->dir)};
+            at = e;
+        }
+    }
+
+    // ships of equal length were placed in scan order; shuffle their ids
+    for (const vector<int> &ids : m_groupIds)
+        for (int k = int(ids.size()) - 1; k > 0; k--)
+            swap(layout[ids[k]], layout[ids[randInt(k + 1)]]);
+    return true;
+}
+
+// helper function
+// draw a layout by placing each ship independently until none overlap
+bool FleetSamplerImpl::sampleByRetrying(vector<ShipPlacement> &layout) const
+{
+    for (const vector<Spot> &spots : m_spots)
+        if (spots.empty())
+            return false;
+    thread_local vector<uint64_t> occupied;
+    occupied.assign((m_rows * m_cols + 63) / 64, 0);
+    auto isOccupied = [](int cell) { return (occupied[cell >> 6] >> (cell & 63)) & 1; };
+    auto flip = [](int cell) { occupied[cell >> 6] ^= uint64_t(1) << (cell & 63); };
+    for (int attempt = 0; attempt < MAXATTEMPTS; attempt++)
+    {
+        int k;
+        for (k = 0; k < m_nShips; k++)
+        {
+            int len = m_groupLength[m_groupOf[k]];
+            const vector<Spot> &spots = m_spots[m_groupOf[k]];
+            const Spot &spot = spots[randInt(spots.size())];
+            int i;
+            for (i = 0; i < len && !isOccupied(spot.first + i * spot.step); i++)
+                ;
+            if (i < len) // overlaps an earlier ship
+                break;
+            for (i = 0; i < len; i++)
+                flip(spot.first + i * spot.step);
+            layout[k] = spot.where;
+        }
+        if (k == m_nShips)
+            return true;
+        for (int j = 0; j < k; j++) // clear the board for the next attempt
+        {
+            Point p = layout[j].topOrLeft;
+            int step = layout[j].dir == HORIZONTAL ? 1 : m_cols;
+            for (int i = 0; i < m_groupLength[m_groupOf[j]]; i++)
+                flip(p.r * m_cols + p.c + i * step);
+        }
+    }
+    return false;
+}
+
+bool FleetSamplerImpl::placeShips(Board &b) const
+{
+    vector<ShipPlacement> layout;
+    b.clear();
+    if (!sample(layout))
+        return false;
+    for (int k = 0; k < m_nShips; k++)
+        if (!b.placeShip(layout[k].topOrLeft, k, layout[k].dir))
+            return false;
+    return true;
+}
+
+//******************** FleetSampler functions *************************
+
+// These functions simply delegate to FleetSamplerImpl's functions.
+
+FleetSampler::FleetSampler(const Game &g, const vector<Point> &blocked)
+{
+    m_impl = new FleetSamplerImpl(g, blocked);
+}
+
+FleetSampler::~FleetSampler()
+{
+    delete m_impl;
+}
+
+bool FleetSampler::countsLayouts() const
+{
+    return m_impl->countsLayouts();
+}
+
+double FleetSampler::nLayouts() const
+{
+    return m_impl->nLayouts();
+}
+
+bool FleetSampler::sample(vector<ShipPlacement> &layout) const
+{
+    return m_impl->sample(layout);
+}
+
+bool FleetSampler::placeShips(Board &b) const
+{
+    return m_impl->placeShips(b);
+}
+
+const FleetSampler &FleetSampler::shared(const Game &g)
+{
+    static mutex samplersLock;
+    static map<vector<int>, unique_ptr<FleetSampler>> samplers;
+    vector<int> shape{g.rows(), g.cols()};
+    for (int k = 0; k < g.nShips(); k++)
+        shape.push_back(g.shipLength(k));
+    lock_guard<mutex> guard(samplersLock);
+    unique_ptr<FleetSampler> &sampler = samplers[shape];
+    if (!sampler)
+        sampler.reset(new FleetSampler(g));
+    return *sampler;
+}
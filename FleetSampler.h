@@ -0,0 +1,51 @@
+#ifndef FLEETSAMPLER_INCLUDED
+#define FLEETSAMPLER_INCLUDED
+
+#include "globals.h"
+#include <vector>
+
+class Game;
+class Board;
+class FleetSamplerImpl;
+
+  // Where one ship of a layout goes
+struct ShipPlacement
+{
+    Point topOrLeft;
+    Direction dir;
+};
+
+  // A FleetSampler draws layouts of a game's fleet uniformly at random from
+  // every layout in which no two ships overlap.  When the layouts can be
+  // counted in a small enough table, a draw is a single pass over the board
+  // with no retries; otherwise each ship is placed independently and the
+  // draw starts over if two of them overlap.  See FleetSampler.cpp.
+class FleetSampler
+{
+  public:
+      // Layouts may not use any of the blocked cells
+    FleetSampler(const Game& g, const std::vector<Point>& blocked = std::vector<Point>());
+    ~FleetSampler();
+      // Return true if the sampler counted the layouts and draws without retries
+    bool countsLayouts() const;
+      // The number of layouts, counting ships of equal length as different,
+      // if the sampler counted them, or 0
+    double nLayouts() const;
+      // Fill layout, indexed by ship id, with a layout drawn from the active
+      // random engine.  Return false if there are no layouts, or if retrying
+      // gave up because they are too rare among independent placements.
+    bool sample(std::vector<ShipPlacement>& layout) const;
+      // Clear b and place a layout drawn from the active random engine on it
+    bool placeShips(Board& b) const;
+      // Return a sampler for g's board and fleet that is shared by every game
+      // of the same shape and kept until the program ends
+    static const FleetSampler& shared(const Game& g);
+      // We prevent a FleetSampler object from being copied or assigned
+    FleetSampler(const FleetSampler&) = delete;
+    FleetSampler& operator=(const FleetSampler&) = delete;
+
+  private:
+    FleetSamplerImpl* m_impl;
+};
+
+#endif // FLEETSAMPLER_INCLUDED
@@ -1,14 +1,25 @@
 #include "Game.h"
 #include "Board.h"
+#include "CellGrid.h"
+#include "FixedGame.h"
 #include "Player.h"
+#include "BuiltinPlayers.h"
+#include "GameState.h"
+#include "Trace.h"
 #include "globals.h"
 #include <iostream>
 #include <string>
 #include <cstdlib>
 #include <cctype>
+#include <chrono>
+#include <typeinfo>
+#include <type_traits>
 
 using namespace std;
 
+struct Salvo;
+struct ShotOutcome;
+
 class GameImpl
 {
 public:
@@ -16,18 +27,36 @@ public:
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
+    bool isValid(int cell) const { return m_grid.isValid(cell); }
+    const CellGrid &grid() const { return m_grid; }
     Point randomPoint() const;
     bool addShip(int length, char symbol, string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    string shipName(int shipId) const;
-    Player *play(Player *p1, Player *p2, Board &b1, Board &b2, bool shouldPause);
+    const string &shipName(int shipId) const;
+    int totalLength() const;
+    void setShotsPerTurn(int n) { m_shotsPerTurn = n; }
+    int shotsPerTurn() const { return m_shotsPerTurn; }
+    // side s, played by attacker, takes its turn against defender: a shot,
+    // or a salvo if there is more than one shot per turn; return true if
+    // that sank the last of defender's ships.  Shape is the game's shape,
+    // StandardGame or RuntimeGame (see FixedGame.h).
+    template <class A, class D, class Fleets, class Shape>
+    bool takeTurn(A *attacker, D *defender, int s, Fleets &fleets, const Shape &shape, ShotOutcome &last,
+                  Salvo &salvo, bool shouldDisplay, GameStats *stats);
 
 private:
     // print the result of attacking
-    void attackMessage(string name, Point cor, bool shotHit, bool shipDestroyed, int shipId);
-    int m_r, m_c, m_size;
+    void attackMessage(const string &name, Point cor, bool shotHit, bool shipDestroyed, int shipId);
+    template <class A, class D, class Fleets, class Shape>
+    bool classicTurn(A *attacker, D *defender, int s, Fleets &fleets, const Shape &shape, ShotOutcome &last,
+                     bool shouldDisplay, GameStats *stats);
+    template <class A, class D, class Fleets, class Shape>
+    bool salvoTurn(A *attacker, D *defender, int s, Fleets &fleets, const Shape &shape, Salvo &salvo,
+                   bool shouldDisplay, GameStats *stats);
+    int m_r, m_c, m_size, m_totalLength, m_shotsPerTurn;
+    const CellGrid &m_grid;
     vector<int> m_sL;
     vector<char> m_sym;
     vector<string> m_name;
@@ -35,7 +64,7 @@ private:
 
 // helper function
 // print the result of attacking
-void GameImpl::attackMessage(string name, Point cor, bool shotHit, bool shipDestroyed, int shipId)
+void GameImpl::attackMessage(const string &name, Point cor, bool shotHit, bool shipDestroyed, int shipId)
 {
     cout << name << " attacked (" << cor.r << "," << cor.c << ") and ";
     if (shotHit)
@@ -55,11 +84,9 @@ void waitForEnter()
 }
 
 GameImpl::GameImpl(int nRows, int nCols)
-    : m_r(nRows), m_c(nCols), m_size(0)
+    : m_r(nRows), m_c(nCols), m_size(0), m_totalLength(0), m_shotsPerTurn(1),
+      m_grid(CellGrid::shared(nRows, nCols))
 {
-    m_sym.push_back('X'); // store the three symbols used to mark board into symbol used
-    m_sym.push_back('o');
-    m_sym.push_back('.');
 }
 
 int GameImpl::rows() const
@@ -84,15 +111,11 @@ Point GameImpl::randomPoint() const
 
 bool GameImpl::addShip(int length, char symbol, string name)
 {
-    for (char i : m_sym) // check symbol not used before
-    {
-        if (symbol == i)
-            return false;
-    }
     m_sym.push_back(symbol); // add the symbol, length, and name to vector
     m_sL.push_back(length);
     m_name.push_back(name);
     m_size++;
+    m_totalLength += length;
     return true;
 }
 
@@ -108,84 +131,467 @@ int GameImpl::shipLength(int shipId) const
 
 char GameImpl::shipSymbol(int shipId) const
 {
-    return m_sym[shipId + 3]; // skip the first three element of the vector
+    return m_sym[shipId];
 }
 
-string GameImpl::shipName(int shipId) const
+const string &GameImpl::shipName(int shipId) const
 {
     return m_name[shipId];
 }
 
-Player *GameImpl::play(Player *p1, Player *p2, Board &b1, Board &b2, bool shouldPause)
+int GameImpl::totalLength() const
 {
-    if (!p1->placeShips(b1) || !p2->placeShips(b2)) // return nullptr if either side placeships failed
-        return nullptr;
-    bool p1Human = p1->isHuman();
-    bool p2Human = p2->isHuman();
-    bool c_shotHit = false, c_shipDestoryed = false;
-    int c_shipId;
-    bool valid;
-    Point cor;
-    // int attackCount = 0;
-    while (true) // infinite loop break when winner found
+    return m_totalLength;
+}
+
+// The fleets of a game small enough for a GameState, where p1's fleet is
+// side 0 and p2's is side 1
+class StateFleets
+{
+public:
+    StateFleets(const Game &g) : m_game(g), m_state(g.rows(), g.cols()) {}
+    bool load(const Board &b1, const Board &b2)
+    {
+        return b1.copyShipsTo(m_state, 0) && b2.copyShipsTo(m_state, 1);
+    }
+    bool attack(int s, Cell cell, bool &shotHit, bool &shipDestroyed, int &shipId)
+    {
+        m_state.setToMove(1 - s);
+        return m_state.attack(cell, shotHit, shipDestroyed, shipId);
+    }
+    void attackBatch(int s, const vector<Cell> &cells, vector<ShotResult> &results)
+    {
+        m_state.setToMove(1 - s);
+        m_state.attackBatch(cells, results);
+    }
+    int shipsLeft(int s) const { return m_state.side(s).shipsLeft; }
+    bool allShipsDestroyed(int s) const { return m_state.allShipsDestroyed(s); }
+    void display(int s, bool shotsOnly) const { m_state.display(m_game, s, shotsOnly); }
+
+private:
+    const Game &m_game;
+    GameState m_state;
+};
+
+// The fleets of a bigger game, left on the boards the players placed them on
+class BoardFleets
+{
+public:
+    BoardFleets(Board *b1, Board *b2) : m_board{b1, b2} {}
+    bool attack(int s, Cell cell, bool &shotHit, bool &shipDestroyed, int &shipId)
+    {
+        return m_board[s]->attack(cell, shotHit, shipDestroyed, shipId);
+    }
+    void attackBatch(int s, const vector<Cell> &cells, vector<ShotResult> &results)
+    {
+        m_board[s]->attackBatch(cells, results);
+    }
+    int shipsLeft(int s) const { return m_board[s]->shipsLeft(); }
+    bool allShipsDestroyed(int s) const { return m_board[s]->allShipsDestroyed(); }
+    void display(int s, bool shotsOnly) const { m_board[s]->display(shotsOnly); }
+
+private:
+    Board *m_board[2];
+};
+
+// A shot as its player chose it: a cell, or a Point that may be off the
+// board and is handed back unchanged when the player is told the result
+struct Shot
+{
+    Cell cell; // NOCELL if off the board
+    Point p;   // only meaningful if byPoint
+    bool byPoint;
+    template <class Shape>
+    Point point(const Shape &shape) const
+    {
+        return byPoint ? p : shape.isValid(cell) ? shape.pointOf(cell) : Point(-1, -1);
+    }
+};
+
+// The trace labels of the players in the seats of the game being played on
+// this thread, set at every step of a TurnLoop while tracing
+thread_local int traceSeats[2] = {-1, -1};
+
+// helper function
+// ask p, in seat s, where to attack, in whichever form it works in
+template <class P, class Shape>
+Shot aim(P *p, const Shape &shape, int s)
+{
+    TraceSpan span("recommendAttack", traceSeats[s]);
+    if (p->attacksByCell())
+        return Shot{p->recommendAttackCell(), Point(), false};
+    Point cor = p->recommendAttack();
+    return Shot{shape.cellOf(cor), cor, true};
+}
+
+// helper function
+// tell the attacker p, in seat s, how its shot went
+template <class P, class Shape>
+void recordResult(P *p, const Shot &shot, const Shape &shape, int s, bool valid, bool shotHit,
+                  bool shipDestroyed, int shipId)
+{
+    TraceSpan span("recordAttackResult", traceSeats[s]);
+    if (p->attacksByCell())
+        p->recordAttackResultAt(shot.cell, valid, shotHit, shipDestroyed, shipId);
+    else
+        p->recordAttackResult(shot.point(shape), valid, shotHit, shipDestroyed, shipId);
+}
+
+// helper function
+// tell p, in seat s, where its opponent shot
+template <class P, class Shape>
+void recordOpponent(P *p, const Shot &shot, const Shape &shape, int s)
+{
+    TraceSpan span("recordAttackByOpponent", traceSeats[s]);
+    if (p->attacksByCell())
+        p->recordAttackByOpponentAt(shot.cell);
+    else
+        p->recordAttackByOpponent(shot.point(shape));
+}
+
+// helper function
+// ask p, in seat s, where to attack and add how long it took to nanos
+template <class P, class Shape>
+Shot timedAim(P *p, const Shape &shape, int s, vector<uint32_t> &nanos)
+{
+    auto begin = chrono::steady_clock::now();
+    Shot shot = aim(p, shape, s);
+    nanos.push_back(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count());
+    return shot;
+}
+
+// helper function
+// count side s's shot at cell
+void countShot(GameStats &stats, int s, Cell cell, bool valid, bool shotHit, bool shipDestroyed,
+               int shipId)
+{
+    stats.shots[s]++;
+    if (!valid)
+    {
+        stats.wasted[s]++;
+        return;
+    }
+    if (shotHit)
+    {
+        if (stats.firstHit[s] == 0)
+            stats.firstHit[s] = stats.shots[s];
+        stats.hits[s].push_back(cell);
+    }
+    if (shipDestroyed)
+        stats.sunk[s].push_back(shipId);
+}
+
+// The shots of one salvo, kept between turns so a game reuses their space
+struct Salvo
+{
+    vector<Point> points;
+    vector<Cell> cells;
+    vector<ShotResult> results;
+};
+
+// What the last shot did.  shipId carries over from turn to turn, because
+// both kinds of fleets set it only on a hit.
+struct ShotOutcome
+{
+    bool shotHit = false;
+    bool shipDestroyed = false;
+    int shipId = 0;
+};
+
+template <class A, class D, class Fleets, class Shape>
+bool GameImpl::takeTurn(A *attacker, D *defender, int s, Fleets &fleets, const Shape &shape, ShotOutcome &last,
+                        Salvo &salvo, bool shouldDisplay, GameStats *stats)
+{
+    if (m_shotsPerTurn != 1)
+        return salvoTurn(attacker, defender, s, fleets, shape, salvo, shouldDisplay, stats);
+    return classicTurn(attacker, defender, s, fleets, shape, last, shouldDisplay, stats);
+}
+
+template <class A, class D, class Fleets, class Shape>
+bool GameImpl::classicTurn(A *attacker, D *defender, int s, Fleets &fleets, const Shape &shape, ShotOutcome &last,
+                           bool shouldDisplay, GameStats *stats)
+{
+    const int target = 1 - s;
+    const bool attackerHuman = attacker->isHuman();
+    if (shouldDisplay)
     {
-        // attackCount++;
-        cout << p1->name() << "'s turn.  Board for " << p2->name() << ":" << endl; // start of p1 attack
-        b2.display(p1Human);
-        cor = p1->recommendAttack();
-        valid = b2.attack(cor, c_shotHit, c_shipDestoryed, c_shipId);
+        cout << attacker->name() << "'s turn.  Board for " << defender->name() << ":" << endl;
+        fleets.display(target, attackerHuman);
+    }
+    Shot shot = (stats != nullptr && stats->timeMoves ? timedAim(attacker, shape, s, stats->moveNanos[s])
+                                                      : aim(attacker, shape, s));
+    bool valid = fleets.attack(target, shot.cell, last.shotHit, last.shipDestroyed, last.shipId);
+    if (stats != nullptr)
+        countShot(*stats, s, shot.cell, valid, last.shotHit, last.shipDestroyed, last.shipId);
+    if (shouldDisplay)
+    {
+        Point cor = shot.point(shape);
         if (!valid)
-            cout << p1->name() << " wasted a shot at (" << cor.r << "," << cor.c << ")." << endl;
-        // cerr << c_shotHit << endl; //test
+            cout << attacker->name() << " wasted a shot at (" << cor.r << "," << cor.c << ")." << endl;
         else
         {
-            attackMessage(p1->name(), cor, c_shotHit, c_shipDestoryed, c_shipId);
-            b2.display(p1Human);
+            attackMessage(attacker->name(), cor, last.shotHit, last.shipDestroyed, last.shipId);
+            fleets.display(target, attackerHuman);
         }
-        if (b2.allShipsDestroyed())
+    }
+    if (fleets.allShipsDestroyed(target))
+    {
+        if (shouldDisplay)
         {
-            cout << p1->name() << " wins!" << endl;
-            // cerr << attackCount << endl;    //test
-            if (p2Human)
+            cout << attacker->name() << " wins!" << endl;
+            if (defender->isHuman())
             {
-                cout << "Here is where " << p1->name() << "'s ships were:" << endl;
-                b1.display(false);
+                cout << "Here is where " << attacker->name() << "'s ships were:" << endl;
+                fleets.display(s, false);
             }
-            return p1;
         }
-        p1->recordAttackResult(cor, valid, c_shotHit, c_shipDestoryed, c_shipId);
-        p2->recordAttackByOpponent(cor);
-        if (shouldPause)
-            waitForEnter();
-
-        cout << p2->name() << "'s turn.  Board for " << p1->name() << ":" << endl; // start of p2 attack
-        b1.display(p2Human);
-        cor = p2->recommendAttack();
-        valid = b1.attack(cor, c_shotHit, c_shipDestoryed, c_shipId);
-        if (!valid)
-            cout << p2->name() << " wasted a shot at (" << cor.r << "," << cor.c << ")." << endl;
-        // cerr << c_shotHit << endl;  //test
-        else
+        return true;
+    }
+    recordResult(attacker, shot, shape, s, valid, last.shotHit, last.shipDestroyed, last.shipId);
+    recordOpponent(defender, shot, shape, target);
+    return false;
+}
+
+template <class A, class D, class Fleets, class Shape>
+bool GameImpl::salvoTurn(A *attacker, D *defender, int s, Fleets &fleets, const Shape &shape, Salvo &salvo,
+                         bool shouldDisplay, GameStats *stats)
+{
+    const int target = 1 - s;
+    const bool timed = stats != nullptr && stats->timeMoves;
+    if (shouldDisplay)
+    {
+        cout << attacker->name() << "'s turn.  Board for " << defender->name() << ":" << endl;
+        fleets.display(target, attacker->isHuman());
+    }
+    int shotsLeft = m_shotsPerTurn > 0 ? m_shotsPerTurn : fleets.shipsLeft(s);
+    while (shotsLeft > 0)
+    {
+        auto begin = timed ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+        uint64_t traced = traceBegin();
+        attacker->recommendAttacks(shotsLeft, salvo.points);
+        traceEnd("recommendAttacks", traced, traceSeats[s]);
+        if (timed)
+            stats->moveNanos[s].push_back(
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count());
+        if (salvo.points.empty()) // it has nothing left to shoot at
+            break;
+        if (int(salvo.points.size()) > shotsLeft)
+            salvo.points.resize(shotsLeft);
+        shotsLeft -= salvo.points.size();
+        salvo.cells.clear();
+        for (const Point &p : salvo.points)
+            salvo.cells.push_back(shape.cellOf(p));
+        fleets.attackBatch(target, salvo.cells, salvo.results);
+
+        for (size_t i = 0; i < salvo.points.size(); i++)
         {
-            attackMessage(p2->name(), cor, c_shotHit, c_shipDestoryed, c_shipId);
-            b1.display(p2Human);
+            const ShotResult &res = salvo.results[i];
+            if (stats != nullptr)
+                countShot(*stats, s, salvo.cells[i], res.valid, res.hit, res.destroyed, res.shipId);
+            if (!shouldDisplay)
+                continue;
+            Point cor = salvo.points[i];
+            if (!res.valid)
+                cout << attacker->name() << " wasted a shot at (" << cor.r << "," << cor.c << ")." << endl;
+            else
+                attackMessage(attacker->name(), cor, res.hit, res.destroyed, res.shipId);
         }
-        if (b1.allShipsDestroyed())
+        if (shouldDisplay)
+            fleets.display(target, attacker->isHuman());
+        if (fleets.allShipsDestroyed(target))
         {
-            cout << p2->name() << " wins!" << endl;
-            if (p1Human)
+            if (shouldDisplay)
             {
-                cout << "Here is where " << p2->name() << "'s ships were:" << endl;
-                b2.display(false);
+                cout << attacker->name() << " wins!" << endl;
+                if (defender->isHuman())
+                {
+                    cout << "Here is where " << attacker->name() << "'s ships were:" << endl;
+                    fleets.display(s, false);
+                }
             }
-            // cerr << attackCount << endl;    //test
-            return p2;
+            return true;
+        }
+        {
+            TraceSpan span("recordAttackResults", traceSeats[s]);
+            attacker->recordAttackResults(salvo.points, salvo.results);
+        }
+        for (size_t i = 0; i < salvo.points.size(); i++)
+            recordOpponent(defender, Shot{salvo.cells[i], salvo.points[i], true}, shape, target);
+    }
+    return false;
+}
+
+
+// The engine behind a GameSession
+class GameSessionImpl
+{
+public:
+    virtual ~GameSessionImpl() {}
+    virtual bool step() = 0;
+    virtual bool isOver() const = 0;
+    virtual Player *winner() const = 0;
+    virtual int turnsPlayed() const = 0;
+    virtual int toMove() const = 0;
+};
+
+// A game between p1 and p2, played a turn at a time.  P1 and P2 are the
+// players' types, as in Game::playStatic, so every call to a player within
+// a turn is bound at compile time.  Shape is StandardGame if the game
+// matches it and RuntimeGame if not, so on the standard game the turns
+// convert between cells and points with constants.
+template <class P1, class P2, class Shape>
+class TurnLoop final : public GameSessionImpl
+{
+public:
+    TurnLoop(const Game &g, GameImpl &impl, const Shape &shape, P1 *p1, P2 *p2, bool shouldPause,
+             bool shouldDisplay, GameStats *stats)
+        : m_game(g), m_impl(impl), m_shape(shape), m_p1(p1), m_p2(p2), m_shouldPause(shouldPause),
+          m_shouldDisplay(shouldDisplay), m_stats(stats), m_b1(nullptr), m_b2(nullptr), m_stateFleets(g),
+          m_boardFleets(nullptr, nullptr), m_started(false), m_over(false), m_onState(false),
+          m_toMove(0), m_turns(0), m_winner(nullptr), m_traceLabels{-1, -1}, m_traceGame(-1),
+          m_traceBegin(0)
+    {
+    }
+    ~TurnLoop() { dropBoards(); }
+    bool step() override;
+    bool isOver() const override { return m_over; }
+    Player *winner() const override { return m_winner; }
+    int turnsPlayed() const override { return m_turns; }
+    int toMove() const override { return m_toMove; }
+
+private:
+    template <class Fleets>
+    bool turn(Fleets &fleets);
+    // end the game, won by winner or by nobody if it is null
+    void finish(Player *winner);
+    // point traceSeats at this game's players, labelling them the first time
+    void labelSeats();
+    void dropBoards();
+    const Game &m_game;
+    GameImpl &m_impl;
+    Shape m_shape;
+    P1 *m_p1;
+    P2 *m_p2;
+    bool m_shouldPause;
+    bool m_shouldDisplay;
+    GameStats *m_stats;
+    Board *m_b1; // the boards the fleets are placed on, kept only if the
+    Board *m_b2; // game is played on them instead of on m_stateFleets
+    StateFleets m_stateFleets;
+    BoardFleets m_boardFleets;
+    bool m_started;
+    bool m_over;
+    bool m_onState; // the fleets were loaded into m_stateFleets
+    int m_toMove;
+    int m_turns;
+    Player *m_winner;
+    ShotOutcome m_last;
+    Salvo m_salvo;
+    int m_traceLabels[2]; // the players', or -1 before the game is traced
+    int m_traceGame;
+    uint64_t m_traceBegin;
+};
+
+template <class P1, class P2, class Shape>
+bool TurnLoop<P1, P2, Shape>::step()
+{
+    if (m_over)
+        return false;
+    if (tracing())
+        labelSeats();
+    if (!m_started)
+    {
+        m_started = true;
+        m_traceBegin = traceBegin();
+        // the players place their ships on boards; if they fit, the game is
+        // then played out on a GameState
+        m_b1 = new Board(m_game);
+        m_b2 = new Board(m_game);
+        bool placed;
+        {
+            TraceSpan span("placeShips", traceSeats[0]);
+            placed = m_p1->placeShips(*m_b1);
+        }
+        if (placed)
+        {
+            TraceSpan span("placeShips", traceSeats[1]);
+            placed = m_p2->placeShips(*m_b2);
+        }
+        m_onState = GameState::fits(m_game);
+        if (placed && m_onState)
+        {
+            placed = m_stateFleets.load(*m_b1, *m_b2);
+            dropBoards(); // the game is played on m_stateFleets from here on
+        }
+        if (!placed) // no winner if either side can't place
+        {
+            finish(nullptr);
+            return false;
         }
-        p2->recordAttackResult(cor, valid, c_shotHit, c_shipDestoryed, c_shipId);
-        p1->recordAttackByOpponent(cor);
-        if (shouldPause)
-            waitForEnter();
+        m_boardFleets = BoardFleets(m_b1, m_b2);
+        if (m_stats != nullptr)
+            m_stats->clear();
+        return true;
+    }
+    return m_onState ? turn(m_stateFleets) : turn(m_boardFleets);
+}
+
+template <class P1, class P2, class Shape>
+template <class Fleets>
+bool TurnLoop<P1, P2, Shape>::turn(Fleets &fleets)
+{
+    uint64_t traced = traceBegin();
+    bool won = m_toMove == 0
+                   ? m_impl.takeTurn(m_p1, m_p2, 0, fleets, m_shape, m_last, m_salvo, m_shouldDisplay, m_stats)
+                   : m_impl.takeTurn(m_p2, m_p1, 1, fleets, m_shape, m_last, m_salvo, m_shouldDisplay, m_stats);
+    traceEnd("turn", traced, traceSeats[m_toMove]);
+    m_turns++;
+    if (won)
+    {
+        finish(m_toMove == 0 ? static_cast<Player *>(m_p1) : static_cast<Player *>(m_p2));
+        return false;
+    }
+    if (m_toMove == 0 ? m_p1->hasForfeited() : m_p2->hasForfeited())
+    {
+        Player *loser = (m_toMove == 0 ? static_cast<Player *>(m_p1) : static_cast<Player *>(m_p2));
+        if (m_shouldDisplay)
+            cout << loser->name() << " forfeits." << endl;
+        finish(m_toMove == 0 ? static_cast<Player *>(m_p2) : static_cast<Player *>(m_p1));
+        return false;
+    }
+    if (m_shouldPause)
+        waitForEnter();
+    m_toMove = 1 - m_toMove;
+    return true;
+}
+
+template <class P1, class P2, class Shape>
+void TurnLoop<P1, P2, Shape>::finish(Player *winner)
+{
+    m_winner = winner;
+    m_over = true;
+    traceEnd("game", m_traceBegin, m_traceGame);
+}
+
+template <class P1, class P2, class Shape>
+void TurnLoop<P1, P2, Shape>::dropBoards()
+{
+    delete m_b1;
+    delete m_b2;
+    m_b1 = m_b2 = nullptr;
+}
+
+template <class P1, class P2, class Shape>
+void TurnLoop<P1, P2, Shape>::labelSeats()
+{
+    if (m_traceLabels[0] < 0)
+    {
+        m_traceLabels[0] = traceLabel(m_p1->name());
+        m_traceLabels[1] = traceLabel(m_p2->name());
+        m_traceGame = traceLabel(m_p1->name() + " vs " + m_p2->name());
     }
+    traceSeats[0] = m_traceLabels[0];
+    traceSeats[1] = m_traceLabels[1];
 }
 
 //******************** Game functions *******************************
@@ -228,6 +634,16 @@ bool Game::isValid(Point p) const
     return m_impl->isValid(p);
 }
 
+bool Game::isValid(int cell) const
+{
+    return m_impl->isValid(cell);
+}
+
+const CellGrid &Game::grid() const
+{
+    return m_impl->grid();
+}
+
 Point Game::randomPoint() const
 {
     return m_impl->randomPoint();
@@ -258,18 +674,9 @@ bool Game::addShip(int length, char symbol, string name)
              << endl;
         return false;
     }
-    int totalOfLengths = 0;
-    for (int s = 0; s < nShips(); s++)
-    {
-        totalOfLengths += shipLength(s);
-        if (shipSymbol(s) == symbol)
-        {
-            cout << "Ship symbol " << symbol
-                 << " must not be used for more than one ship" << endl;
-            return false;
-        }
-    }
-    if (totalOfLengths + length > rows() * cols())
+    // ships are told apart by their ids, so symbols are only for display and
+    // big fleets may reuse them
+    if (m_impl->totalLength() + length > rows() * cols())
     {
         cout << "Board is too small to fit all ships" << endl;
         return false;
@@ -294,17 +701,128 @@ char Game::shipSymbol(int shipId) const
     return m_impl->shipSymbol(shipId);
 }
 
-string Game::shipName(int shipId) const
+const string &Game::shipName(int shipId) const
 {
     assert(shipId >= 0 && shipId < nShips());
     return m_impl->shipName(shipId);
 }
 
-Player *Game::play(Player *p1, Player *p2, bool shouldPause)
+void Game::setShotsPerTurn(int n)
+{
+    m_impl->setShotsPerTurn(n < 0 ? 1 : n);
+}
+
+int Game::shotsPerTurn() const
+{
+    return m_impl->shotsPerTurn();
+}
+
+// helper function
+// call f with p as its own type if it is a built-in player, else as a Player
+template <class F>
+auto withPlayerType(Player *p, F f) -> decltype(f(p))
+{
+    if (typeid(*p) == typeid(GoodPlayer))
+        return f(static_cast<GoodPlayer *>(p));
+    if (typeid(*p) == typeid(MediocrePlayer))
+        return f(static_cast<MediocrePlayer *>(p));
+    if (typeid(*p) == typeid(AwfulPlayer))
+        return f(static_cast<AwfulPlayer *>(p));
+    return f(p);
+}
+
+Player *Game::play(Player *p1, Player *p2, bool shouldPause, bool shouldDisplay, GameStats *stats)
+{
+    if (p1 == nullptr || p2 == nullptr)
+        return nullptr;
+    return withPlayerType(p1, [&](auto *q1) {
+        return withPlayerType(p2, [&](auto *q2) { return playStatic(q1, q2, shouldPause, shouldDisplay, stats); });
+    });
+}
+
+// helper function
+// play a game of the given shape between p1 and p2 to the end; return the winner
+template <class P1, class P2, class Shape>
+Player *playOut(const Game &g, GameImpl &impl, const Shape &shape, P1 *p1, P2 *p2, bool shouldPause,
+                bool shouldDisplay, GameStats *stats)
+{
+    TurnLoop<P1, P2, Shape> loop(g, impl, shape, p1, p2, shouldPause, shouldDisplay, stats);
+    while (loop.step())
+    {
+    }
+    return loop.winner();
+}
+
+template <class P1, class P2>
+Player *Game::playStatic(P1 *p1, P2 *p2, bool shouldPause, bool shouldDisplay, GameStats *stats)
 {
     if (p1 == nullptr || p2 == nullptr || nShips() == 0)
         return nullptr;
-    Board b1(*this);
-    Board b2(*this);
-    return m_impl->play(p1, p2, b1, b2, shouldPause);
+    if (StandardGame::matches(*this))
+        return playOut(*this, *m_impl, StandardGame(), p1, p2, shouldPause, shouldDisplay, stats);
+    return playOut(*this, *m_impl, RuntimeGame(*this), p1, p2, shouldPause, shouldDisplay, stats);
+}
+
+// every pairing Game::play can dispatch to, so callers can name them too
+#define INSTANTIATE_PLAY_STATIC(P1)                                                     \
+    template Player *Game::playStatic(P1 *, Player *, bool, bool, GameStats *);         \
+    template Player *Game::playStatic(P1 *, AwfulPlayer *, bool, bool, GameStats *);    \
+    template Player *Game::playStatic(P1 *, MediocrePlayer *, bool, bool, GameStats *); \
+    template Player *Game::playStatic(P1 *, GoodPlayer *, bool, bool, GameStats *);
+INSTANTIATE_PLAY_STATIC(Player)
+INSTANTIATE_PLAY_STATIC(AwfulPlayer)
+INSTANTIATE_PLAY_STATIC(MediocrePlayer)
+INSTANTIATE_PLAY_STATIC(GoodPlayer)
+#undef INSTANTIATE_PLAY_STATIC
+
+//******************** GameSession functions *******************************
+
+GameSession::GameSession(Game &g, Player *p1, Player *p2, bool shouldPause, bool shouldDisplay,
+                         GameStats *stats)
+    : m_impl(nullptr)
+{
+    if (p1 == nullptr || p2 == nullptr || g.nShips() == 0)
+        return;
+    // the same pairings Game::play dispatches to
+    m_impl = withPlayerType(p1, [&](auto *q1) {
+        return withPlayerType(p2, [&](auto *q2) -> GameSessionImpl * {
+            typedef remove_pointer_t<decltype(q1)> P1;
+            typedef remove_pointer_t<decltype(q2)> P2;
+            if (StandardGame::matches(g))
+                return new TurnLoop<P1, P2, StandardGame>(g, *g.m_impl, StandardGame(), q1, q2, shouldPause,
+                                                          shouldDisplay, stats);
+            return new TurnLoop<P1, P2, RuntimeGame>(g, *g.m_impl, RuntimeGame(g), q1, q2, shouldPause,
+                                                     shouldDisplay, stats);
+        });
+    });
+}
+
+GameSession::~GameSession()
+{
+    delete m_impl;
+}
+
+bool GameSession::step()
+{
+    return m_impl != nullptr && m_impl->step();
+}
+
+bool GameSession::isOver() const
+{
+    return m_impl == nullptr || m_impl->isOver();
+}
+
+Player *GameSession::winner() const
+{
+    return m_impl != nullptr ? m_impl->winner() : nullptr;
+}
+
+int GameSession::turnsPlayed() const
+{
+    return m_impl != nullptr ? m_impl->turnsPlayed() : 0;
+}
+
+int GameSession::toMove() const
+{
+    return m_impl != nullptr ? m_impl->toMove() : 0;
 }
@@ -1,12 +1,49 @@
 #ifndef GAME_INCLUDED
 #define GAME_INCLUDED
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 #include <cassert>
 
 class Point;
 class Player;
+class CellGrid;
 class GameImpl;
+class GameSessionImpl;
+
+  // What each side did in a game.  Side 0 is the player that moved first.
+struct GameStats
+{
+    int shots[2];             // attacks made, valid or not
+    int wasted[2];            // attacks off the board or at a cell already attacked
+    int firstHit[2];          // which of the side's attacks first hit a ship, or 0
+    std::vector<int> sunk[2]; // ids of the ships the side sank, in the order it sank them
+    std::vector<int> hits[2]; // the cells the side hit, in order
+    bool timeMoves = false;   // set this to fill in moveNanos
+    std::vector<uint32_t> moveNanos[2]; // how long each of the side's recommendAttack calls took
+      // Forget the last game, but not timeMoves
+    void clear()
+    {
+        for (int s = 0; s < 2; s++)
+        {
+            shots[s] = wasted[s] = firstHit[s] = 0;
+            sunk[s].clear();
+            hits[s].clear();
+            moveNanos[s].clear();
+        }
+    }
+    void swapSides()
+    {
+        std::swap(shots[0], shots[1]);
+        std::swap(wasted[0], wasted[1]);
+        std::swap(firstHit[0], firstHit[1]);
+        sunk[0].swap(sunk[1]);
+        hits[0].swap(hits[1]);
+        moveNanos[0].swap(moveNanos[1]);
+    }
+};
 
 class Game
 {
@@ -16,19 +53,65 @@ class Game
     int rows() const;
     int cols() const;
     bool isValid(Point p) const;
+    bool isValid(int cell) const;
+      // The numbering of this game's cells, with its neighbor and ray tables
+    const CellGrid& grid() const;
     Point randomPoint() const;
     bool addShip(int length, char symbol, std::string name);
     int nShips() const;
     int shipLength(int shipId) const;
     char shipSymbol(int shipId) const;
-    std::string shipName(int shipId) const;
-    Player* play(Player* p1, Player* p2, bool shouldPause = true);
+    const std::string& shipName(int shipId) const;
+      // Each turn a player fires n shots as a salvo, or with n == 0, one per
+      // ship it has left.  The default of 1 is the classic game.
+    void setShotsPerTurn(int n);
+    int shotsPerTurn() const;
+      // Play through p1's and p2's vtables, unless both are built-in players,
+      // in which case this plays the matching playStatic.  If stats isn't
+      // null, it is filled in with what each side did.
+    Player* play(Player* p1, Player* p2, bool shouldPause = true,
+                 bool shouldDisplay = true, GameStats* stats = nullptr);
+      // Play with every call to p1 and p2 bound at compile time.  P1 and P2
+      // are each Player or one of the final types in BuiltinPlayers.h; those
+      // are the only ones Game.cpp instantiates.
+    template <class P1, class P2>
+    Player* playStatic(P1* p1, P2* p2, bool shouldPause = true,
+                       bool shouldDisplay = true, GameStats* stats = nullptr);
       // We prevent a Game object from being copied or assigned
     Game(const Game&) = delete;
     Game& operator=(const Game&) = delete;
 
   private:
+    friend class GameSession;
     GameImpl* m_impl;
 };
 
+  // A game played one step at a time, so a scheduler can interleave many
+  // games on one thread, set one aside and come back to it, or advance it
+  // from its own event loop.  The first step places both fleets, and each
+  // step after that is one player's turn: a shot, or a salvo.  Game::play
+  // is the same thing run to the end.  g, p1 and p2 must outlive the session.
+class GameSession
+{
+  public:
+    GameSession(Game& g, Player* p1, Player* p2, bool shouldPause = false,
+                bool shouldDisplay = false, GameStats* stats = nullptr);
+    ~GameSession();
+      // Take the next step; return false once the game is over, or if it
+      // could not be set up
+    bool step();
+    bool isOver() const;
+      // The player who won, or nullptr if nobody has (yet)
+    Player* winner() const;
+    int turnsPlayed() const;
+      // Whose turn is next: 0 for p1, 1 for p2
+    int toMove() const;
+      // We prevent a GameSession object from being copied or assigned
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+
+  private:
+    GameSessionImpl* m_impl;
+};
+
 #endif // GAME_INCLUDED
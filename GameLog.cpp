@@ -0,0 +1,465 @@
+#include "GameLog.h"
+#include "Game.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// A game log is a header, the player type names, each ending in a NUL and
+// padded together to a multiple of 8 bytes, and then blocks of up to
+// BLOCK_GAMES games.  A block starts with a BlockHeader giving the offset of
+// each column from the start of the block.  A column is a ColumnHeader and
+// then its values, width bits each, packed into 64-bit words from the low
+// bit up.  A FRAME column stores each value minus base, the column's
+// smallest value; a DELTA column stores each value minus the one before it
+// (base for the first), zigzag encoded so small negative differences stay
+// small.  The writer picks whichever needs fewer bits.  Everything is 8 byte
+// aligned and in the byte order of the machine that wrote it.
+
+struct LogHeader
+{
+    char magic[8]; // "BSGAMES\0"
+    uint32_t version;
+    uint32_t nColumns;
+    uint32_t nTypes;
+    uint32_t typeBytes; // of the names that follow, with padding
+};
+
+struct BlockHeader
+{
+    uint32_t nGames;
+    uint32_t size; // in bytes, this header included
+    uint32_t offset[NLOGCOLUMNS];
+    uint32_t unused;
+};
+
+struct ColumnHeader
+{
+    uint32_t count;
+    uint8_t mode;
+    uint8_t width;
+    uint16_t unused;
+    int64_t base;
+};
+
+static_assert(sizeof(LogHeader) % 8 == 0 && sizeof(BlockHeader) % 8 == 0 &&
+                  sizeof(ColumnHeader) == 16,
+              "log headers keep the words after them aligned");
+
+const char LOG_MAGIC[8] = {'B', 'S', 'G', 'A', 'M', 'E', 'S', '\0'};
+const uint32_t LOG_VERSION = 1;
+const uint8_t FRAME = 0, DELTA = 1;
+const int BLOCK_GAMES = 4096;
+
+const char *const columnNames[NLOGCOLUMNS] = {
+    "seed", "firstType", "secondType", "firstMover", "winner",
+    "firstShots", "secondShots", "firstWasted", "secondWasted",
+    "firstHitFirst", "secondHitFirst", "firstSunk", "secondSunk",
+    "firstSinkOrder", "secondSinkOrder"};
+
+const char *gameLogColumnName(int c)
+{
+    return c >= 0 && c < NLOGCOLUMNS ? columnNames[c] : nullptr;
+}
+
+// helper function
+// the number of bits needed for every value whose bits are all in mask
+int bitWidth(uint64_t mask)
+{
+    return mask == 0 ? 0 : 64 - __builtin_clzll(mask);
+}
+
+uint64_t zigzag(uint64_t difference)
+{
+    return (difference << 1) ^ uint64_t(int64_t(difference) >> 63);
+}
+
+uint64_t unzigzag(uint64_t u)
+{
+    return (u >> 1) ^ (0 - (u & 1));
+}
+
+// helper function
+// the number of 64-bit words a column takes up, header included
+size_t columnWords(const ColumnHeader &header)
+{
+    return 2 + (uint64_t(header.count) * header.width + 63) / 64;
+}
+
+// helper function
+// append a column holding values to out
+void packColumn(const vector<int64_t> &values, vector<uint64_t> &out)
+{
+    ColumnHeader header{uint32_t(values.size()), FRAME, 0, 0, 0};
+    if (!values.empty())
+    {
+        int64_t lowest = *min_element(values.begin(), values.end());
+        uint64_t frameBits = 0, deltaBits = 0;
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            frameBits |= uint64_t(values[i]) - uint64_t(lowest);
+            if (i > 0)
+                deltaBits |= zigzag(uint64_t(values[i]) - uint64_t(values[i - 1]));
+        }
+        if (bitWidth(deltaBits) < bitWidth(frameBits))
+            header = ColumnHeader{header.count, DELTA, uint8_t(bitWidth(deltaBits)), 0, values[0]};
+        else
+            header = ColumnHeader{header.count, FRAME, uint8_t(bitWidth(frameBits)), 0, lowest};
+    }
+    size_t start = out.size();
+    out.resize(start + columnWords(header), 0);
+    memcpy(&out[start], &header, sizeof(header));
+    uint64_t *words = &out[start + 2];
+    const int width = header.width;
+    if (width == 0)
+        return;
+    uint64_t previous = header.base, bit = 0;
+    for (int64_t v : values)
+    {
+        uint64_t u = (header.mode == DELTA ? zigzag(uint64_t(v) - previous) : uint64_t(v) - uint64_t(header.base));
+        previous = v;
+        int shift = bit & 63;
+        words[bit >> 6] |= u << shift;
+        if (shift + width > 64)
+            words[(bit >> 6) + 1] |= u >> (64 - shift);
+        bit += width;
+    }
+}
+
+// helper function
+// append the values of the column at p to values
+void unpackColumn(const unsigned char *p, vector<int64_t> &values)
+{
+    ColumnHeader header;
+    memcpy(&header, p, sizeof(header));
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(p + sizeof(header));
+    size_t start = values.size();
+    values.resize(start + header.count);
+    int64_t *out = values.data() + start;
+    const int width = header.width;
+    const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    uint64_t bit = 0;
+    auto next = [&]() {
+        if (width == 0)
+            return uint64_t(0);
+        int shift = bit & 63;
+        uint64_t u = words[bit >> 6] >> shift;
+        if (shift + width > 64)
+            u |= words[(bit >> 6) + 1] << (64 - shift);
+        bit += width;
+        return u & mask;
+    };
+    if (header.mode == DELTA)
+    {
+        uint64_t value = header.base;
+        for (uint32_t i = 0; i < header.count; i++)
+        {
+            value += unzigzag(next());
+            out[i] = value;
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < header.count; i++)
+            out[i] = uint64_t(header.base) + next();
+    }
+}
+
+class GameLogWriterImpl
+{
+public:
+    GameLogWriterImpl(const string &path, const vector<string> &types);
+    ~GameLogWriterImpl() { close(); }
+    bool isOpen() const { return m_out.is_open(); }
+    int typeIndex(const string &type) const;
+    bool add(const GameRecord &r);
+    bool close();
+
+private:
+    // write the buffered games as a block; the caller holds m_lock
+    bool flush();
+    mutex m_lock;
+    ofstream m_out;
+    bool m_ok;
+    vector<string> m_types;
+    int m_buffered;
+    vector<int64_t> m_columns[NLOGCOLUMNS];
+    vector<uint64_t> m_block;
+};
+
+GameLogWriterImpl::GameLogWriterImpl(const string &path, const vector<string> &types)
+    : m_out(path, ios::binary | ios::trunc), m_ok(true), m_types(types), m_buffered(0)
+{
+    if (!m_out)
+        return;
+    string names;
+    for (const string &type : types)
+        names += type + '\0';
+    names.resize((names.size() + 7) / 8 * 8, '\0');
+    LogHeader header;
+    memcpy(header.magic, LOG_MAGIC, sizeof(header.magic));
+    header.version = LOG_VERSION;
+    header.nColumns = NLOGCOLUMNS;
+    header.nTypes = types.size();
+    header.typeBytes = names.size();
+    m_out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    m_out.write(names.data(), names.size());
+    for (vector<int64_t> &column : m_columns)
+        column.reserve(BLOCK_GAMES);
+}
+
+int GameLogWriterImpl::typeIndex(const string &type) const
+{
+    for (size_t i = 0; i < m_types.size(); i++)
+        if (m_types[i] == type)
+            return i;
+    return -1;
+}
+
+bool GameLogWriterImpl::add(const GameRecord &r)
+{
+    const int nTypes = m_types.size();
+    if (r.firstType < 0 || r.firstType >= nTypes || r.secondType < 0 || r.secondType >= nTypes)
+        return false;
+    lock_guard<mutex> guard(m_lock);
+    if (!m_out.is_open())
+        return false;
+    const GameStats &s = r.stats;
+    const int64_t row[LOG_FIRST_SINK_ORDER] = {
+        int64_t(r.seed), r.firstType, r.secondType, r.firstMover, r.winner,
+        s.shots[0], s.shots[1], s.wasted[0], s.wasted[1],
+        s.firstHit[0], s.firstHit[1], int64_t(s.sunk[0].size()), int64_t(s.sunk[1].size())};
+    for (int c = 0; c < LOG_FIRST_SINK_ORDER; c++)
+        m_columns[c].push_back(row[c]);
+    for (int side = 0; side < 2; side++)
+        m_columns[LOG_FIRST_SINK_ORDER + side].insert(m_columns[LOG_FIRST_SINK_ORDER + side].end(),
+                                                      s.sunk[side].begin(), s.sunk[side].end());
+    if (++m_buffered == BLOCK_GAMES)
+        return flush();
+    return m_ok;
+}
+
+bool GameLogWriterImpl::flush()
+{
+    const size_t headerWords = sizeof(BlockHeader) / 8;
+    BlockHeader header;
+    memset(&header, 0, sizeof(header));
+    header.nGames = m_buffered;
+    m_block.assign(headerWords, 0);
+    for (int c = 0; c < NLOGCOLUMNS; c++)
+    {
+        header.offset[c] = 8 * m_block.size();
+        packColumn(m_columns[c], m_block);
+        m_columns[c].clear();
+    }
+    header.size = 8 * m_block.size();
+    memcpy(m_block.data(), &header, sizeof(header));
+    m_out.write(reinterpret_cast<const char *>(m_block.data()), header.size);
+    m_buffered = 0;
+    m_ok = m_ok && bool(m_out);
+    return m_ok;
+}
+
+bool GameLogWriterImpl::close()
+{
+    lock_guard<mutex> guard(m_lock);
+    if (!m_out.is_open())
+        return m_ok;
+    if (m_buffered > 0)
+        flush();
+    m_out.close();
+    m_ok = m_ok && bool(m_out);
+    return m_ok;
+}
+
+class GameLogReaderImpl
+{
+public:
+    GameLogReaderImpl(const string &path);
+    ~GameLogReaderImpl();
+    bool isOpen() const { return m_memory != MAP_FAILED; }
+    long nGames() const { return m_nGames; }
+    const vector<string> &types() const { return m_types; }
+    long size() const { return m_mapped; }
+    void column(int c, vector<int64_t> &values) const;
+
+private:
+    // return true if the block at p, with bytesLeft bytes of file from p on,
+    // is complete and every column in it lies inside it
+    static bool blockIsSound(const unsigned char *p, size_t bytesLeft);
+    void *m_memory;
+    size_t m_mapped;
+    vector<string> m_types;
+    vector<const unsigned char *> m_blocks;
+    long m_nGames;
+};
+
+GameLogReaderImpl::GameLogReaderImpl(const string &path)
+    : m_memory(MAP_FAILED), m_mapped(0), m_nGames(0)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(LogHeader))
+    {
+        m_mapped = st.st_size;
+        m_memory = mmap(nullptr, m_mapped, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd); // the mapping keeps the file open
+    if (m_memory == MAP_FAILED)
+        return;
+
+    const unsigned char *base = static_cast<const unsigned char *>(m_memory);
+    LogHeader header;
+    memcpy(&header, base, sizeof(header));
+    if (memcmp(header.magic, LOG_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != LOG_VERSION || header.nColumns != NLOGCOLUMNS ||
+        header.typeBytes % 8 != 0 || m_mapped - sizeof(header) < header.typeBytes)
+    {
+        munmap(m_memory, m_mapped);
+        m_memory = MAP_FAILED;
+        return;
+    }
+    const char *names = reinterpret_cast<const char *>(base + sizeof(header));
+    for (size_t pos = 0; m_types.size() < header.nTypes && pos < header.typeBytes;)
+    {
+        size_t len = strnlen(names + pos, header.typeBytes - pos);
+        m_types.push_back(string(names + pos, len));
+        pos += len + 1;
+    }
+
+    // stop at the first block that isn't all there
+    size_t pos = sizeof(header) + header.typeBytes;
+    while (blockIsSound(base + pos, m_mapped - pos))
+    {
+        const BlockHeader *block = reinterpret_cast<const BlockHeader *>(base + pos);
+        m_blocks.push_back(base + pos);
+        m_nGames += block->nGames;
+        pos += block->size;
+    }
+}
+
+bool GameLogReaderImpl::blockIsSound(const unsigned char *p, size_t bytesLeft)
+{
+    if (bytesLeft < sizeof(BlockHeader))
+        return false;
+    const BlockHeader *block = reinterpret_cast<const BlockHeader *>(p);
+    if (block->size < sizeof(BlockHeader) || block->size > bytesLeft || block->size % 8 != 0)
+        return false;
+    for (int c = 0; c < NLOGCOLUMNS; c++)
+    {
+        uint32_t offset = block->offset[c];
+        if (offset % 8 != 0 || offset < sizeof(BlockHeader) || offset + sizeof(ColumnHeader) > block->size)
+            return false;
+        ColumnHeader column;
+        memcpy(&column, p + offset, sizeof(column));
+        if (column.width > 64 || column.mode > DELTA ||
+            (c < LOG_FIRST_SINK_ORDER && column.count != block->nGames) ||
+            offset + 8 * columnWords(column) > block->size)
+            return false;
+    }
+    return true;
+}
+
+GameLogReaderImpl::~GameLogReaderImpl()
+{
+    if (m_memory != MAP_FAILED)
+        munmap(m_memory, m_mapped);
+}
+
+void GameLogReaderImpl::column(int c, vector<int64_t> &values) const
+{
+    values.clear();
+    if (c < 0 || c >= NLOGCOLUMNS)
+        return;
+    size_t count = 0;
+    for (const unsigned char *block : m_blocks)
+        count += reinterpret_cast<const ColumnHeader *>(
+                     block + reinterpret_cast<const BlockHeader *>(block)->offset[c])->count;
+    values.reserve(count);
+    for (const unsigned char *block : m_blocks)
+        unpackColumn(block + reinterpret_cast<const BlockHeader *>(block)->offset[c], values);
+}
+
+//******************** GameLogWriter functions ************************
+
+// These functions simply delegate to GameLogWriterImpl's functions.
+
+GameLogWriter::GameLogWriter(const string &path, const vector<string> &types)
+{
+    m_impl = new GameLogWriterImpl(path, types);
+}
+
+GameLogWriter::~GameLogWriter()
+{
+    delete m_impl;
+}
+
+bool GameLogWriter::isOpen() const
+{
+    return m_impl->isOpen();
+}
+
+int GameLogWriter::typeIndex(const string &type) const
+{
+    return m_impl->typeIndex(type);
+}
+
+bool GameLogWriter::add(const GameRecord &r)
+{
+    return m_impl->add(r);
+}
+
+bool GameLogWriter::close()
+{
+    return m_impl->close();
+}
+
+//******************** GameLogReader functions ************************
+
+// These functions simply delegate to GameLogReaderImpl's functions.
+
+GameLogReader::GameLogReader(const string &path)
+{
+    m_impl = new GameLogReaderImpl(path);
+}
+
+GameLogReader::~GameLogReader()
+{
+    delete m_impl;
+}
+
+bool GameLogReader::isOpen() const
+{
+    return m_impl->isOpen();
+}
+
+long GameLogReader::nGames() const
+{
+    return m_impl->nGames();
+}
+
+const vector<string> &GameLogReader::types() const
+{
+    return m_impl->types();
+}
+
+long GameLogReader::size() const
+{
+    return m_impl->size();
+}
+
+void GameLogReader::column(int c, vector<int64_t> &values) const
+{
+    m_impl->column(c, values);
+}
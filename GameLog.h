@@ -0,0 +1,85 @@
+#ifndef GAMELOG_INCLUDED
+#define GAMELOG_INCLUDED
+
+#include "Game.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GameLogWriterImpl;
+class GameLogReaderImpl;
+
+  // The columns of a game log.  Each game has one value in every column but
+  // the two sink orders, which hold the ids of the ships a side sank, in
+  // order, for every game in turn; the sunk columns say how many belong to each.
+enum GameLogColumn {
+    LOG_SEED, LOG_FIRST_TYPE, LOG_SECOND_TYPE, LOG_FIRST_MOVER, LOG_WINNER,
+    LOG_FIRST_SHOTS, LOG_SECOND_SHOTS, LOG_FIRST_WASTED, LOG_SECOND_WASTED,
+    LOG_FIRST_HIT_FIRST, LOG_SECOND_HIT_FIRST, LOG_FIRST_SUNK, LOG_SECOND_SUNK,
+    LOG_FIRST_SINK_ORDER, LOG_SECOND_SINK_ORDER, NLOGCOLUMNS
+};
+
+  // The name the commands in main.cpp use for column c, or nullptr
+const char* gameLogColumnName(int c);
+
+  // One game between two player types
+struct GameRecord
+{
+    uint64_t seed;
+    int firstType;   // index into the log's types
+    int secondType;
+    int firstMover;  // 0 if first moved first, 1 if second did
+    int winner;      // 0 if nobody won, 1 if first did, 2 if second did
+    GameStats stats; // side 0 is first and side 1 is second, whoever moved first
+};
+
+  // A GameLogWriter streams games into a columnar file.  Games are buffered
+  // a block at a time, and each column of a block is written on its own,
+  // packed into as few bits per game as its values (or the differences
+  // between consecutive values, if those are smaller) need.  Games may be
+  // added from several threads at once.
+class GameLogWriter
+{
+  public:
+    GameLogWriter(const std::string& path, const std::vector<std::string>& types);
+    ~GameLogWriter(); // closes the log
+    bool isOpen() const;
+      // The index of type in the log's types, or -1
+    int typeIndex(const std::string& type) const;
+      // Return false if the log isn't open or r names an unknown type
+    bool add(const GameRecord& r);
+      // Write any games still buffered and close the file; return false if
+      // any write failed
+    bool close();
+      // We prevent a GameLogWriter object from being copied or assigned
+    GameLogWriter(const GameLogWriter&) = delete;
+    GameLogWriter& operator=(const GameLogWriter&) = delete;
+
+  private:
+    GameLogWriterImpl* m_impl;
+};
+
+  // A GameLogReader maps a game log into memory and unpacks one column at a
+  // time, touching only that column's bytes.  A log cut short by a crash
+  // reads as the blocks written before it.
+class GameLogReader
+{
+  public:
+    GameLogReader(const std::string& path);
+    ~GameLogReader();
+    bool isOpen() const;
+    long nGames() const;
+    const std::vector<std::string>& types() const;
+      // The bytes of the file
+    long size() const;
+      // Replace values with column c of every game, in the order written
+    void column(int c, std::vector<int64_t>& values) const;
+      // We prevent a GameLogReader object from being copied or assigned
+    GameLogReader(const GameLogReader&) = delete;
+    GameLogReader& operator=(const GameLogReader&) = delete;
+
+  private:
+    GameLogReaderImpl* m_impl;
+};
+
+#endif // GAMELOG_INCLUDED
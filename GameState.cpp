@@ -0,0 +1,166 @@
+#include "GameState.h"
+#include "Game.h"
+#include <iostream>
+
+using namespace std;
+
+GameState::GameState()
+    : GameState(0, 0)
+{
+}
+
+GameState::GameState(int nRows, int nCols)
+    : m_rows(nRows), m_cols(nCols), m_toMove(0)
+{
+    m_side[0] = m_side[1] = SideState{};
+}
+
+bool GameState::fits(const Game &g)
+{
+    return g.rows() * g.cols() <= MAXCELLS;
+}
+
+bool GameState::placeShip(int s, Point topOrLeft, int shipId, int length, Direction dir)
+{
+    int dr = (dir == VERTICAL), dc = (dir == HORIZONTAL);
+    int endR = topOrLeft.r + dr * (length - 1);
+    int endC = topOrLeft.c + dc * (length - 1);
+    if (topOrLeft.r < 0 || topOrLeft.c < 0 || endR >= m_rows || endC >= m_cols)
+        return false;
+    SideState &side = m_side[s];
+    for (int i = 0; i < length; i++) // check whether all cells are clear
+        if (side.ships.contains(cellOf(Point(topOrLeft.r + dr * i, topOrLeft.c + dc * i))))
+            return false;
+    for (int i = 0; i < length; i++)
+    {
+        int cell = cellOf(Point(topOrLeft.r + dr * i, topOrLeft.c + dc * i));
+        side.ships.insert(cell);
+        side.shipAt[cell] = shipId;
+    }
+    side.hitsLeft[shipId] = length;
+    side.shipsLeft++;
+    return true;
+}
+
+bool GameState::attack(Point p, bool &shotHit, bool &shipDestroyed, int &shipId,
+                       GameStateJournal *journal)
+{
+    bool onBoard = p.r >= 0 && p.r < m_rows && p.c >= 0 && p.c < m_cols;
+    return attack(onBoard ? cellOf(p) : NOCELL, shotHit, shipDestroyed, shipId, journal);
+}
+
+bool GameState::attack(Cell cell, bool &shotHit, bool &shipDestroyed, int &shipId,
+                       GameStateJournal *journal)
+{
+    int attacker = m_toMove;
+    m_toMove = 1 - m_toMove;
+    shotHit = false;
+    shipDestroyed = false;
+    SideState &side = m_side[1 - attacker];
+    if (unsigned(cell) >= unsigned(m_rows * m_cols) || side.shots.contains(cell))
+    {
+        if (journal != nullptr)
+            journal->m_entries.push_back({uint8_t(attacker), 0, 0, GameStateJournal::NOSHIP});
+        return false;
+    }
+
+    side.shots.insert(cell);
+    uint8_t hitShip = GameStateJournal::NOSHIP;
+    if (side.ships.contains(cell))
+    {
+        shotHit = true;
+        hitShip = side.shipAt[cell];
+        shipId = hitShip;
+        if (--side.hitsLeft[hitShip] == 0)
+        {
+            shipDestroyed = true;
+            side.shipsLeft--;
+        }
+    }
+    if (journal != nullptr)
+        journal->m_entries.push_back({uint8_t(attacker), uint8_t(cell), 1, hitShip});
+    return true;
+}
+
+int GameState::attackBatch(const vector<Cell> &cells, vector<ShotResult> &results)
+{
+    int attacker = m_toMove;
+    m_toMove = 1 - m_toMove;
+    SideState &side = m_side[1 - attacker];
+    const unsigned nCells = m_rows * m_cols;
+    CellSet salvo;
+    for (Cell cell : cells)
+        if (unsigned(cell) < nCells)
+            salvo.insert(cell);
+    // the cells not shot before, and which of them hit, for the whole salvo at once
+    CellSet fresh = salvo.without(side.shots);
+    CellSet hits = fresh & side.ships;
+    side.shots = side.shots | fresh;
+
+    const int n = cells.size();
+    results.resize(n);
+    for (int i = 0; i < n; i++)
+    {
+        const Cell cell = cells[i];
+        ShotResult &res = results[i];
+        res.valid = unsigned(cell) < nCells && fresh.contains(cell);
+        res.hit = res.destroyed = false;
+        if (!res.valid)
+            continue;
+        fresh.erase(cell); // firing at it again in this salvo is wasted
+        if (!hits.contains(cell))
+            continue;
+        res.hit = true;
+        res.shipId = side.shipAt[cell];
+        if (--side.hitsLeft[res.shipId] == 0)
+        {
+            res.destroyed = true;
+            side.shipsLeft--;
+        }
+    }
+    return hits.size();
+}
+
+void GameState::display(const Game &g, int s, bool shotsOnly) const
+{
+    const SideState &side = m_side[s];
+    cout << "  ";
+    for (int c = 0; c < m_cols; c++)
+        cout << c;
+    cout << endl;
+
+    for (int r = 0; r < m_rows; r++)
+    {
+        cout << r << " ";
+        for (int c = 0; c < m_cols; c++)
+        {
+            int cell = cellOf(Point(r, c));
+            if (side.shots.contains(cell)) // show hits and misses
+                cout << (side.ships.contains(cell) ? 'X' : 'o');
+            else if (!shotsOnly && side.ships.contains(cell)) // and ships unless they're hidden
+                cout << g.shipSymbol(side.shipAt[cell]);
+            else
+                cout << '.';
+        }
+        cout << endl;
+    }
+}
+
+void GameStateJournal::restore(GameState &state, int mark)
+{
+    while (int(m_entries.size()) > mark) // undo attacks newest first
+    {
+        Entry e = m_entries.back();
+        m_entries.pop_back();
+        state.m_toMove = e.attacker;
+        if (!e.valid)
+            continue;
+        SideState &side = state.m_side[1 - e.attacker];
+        side.shots.erase(e.cell);
+        if (e.shipId != NOSHIP)
+        {
+            if (side.hitsLeft[e.shipId]++ == 0)
+                side.shipsLeft++;
+        }
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef GAMESTATE_INCLUDED
+#define GAMESTATE_INCLUDED
+
+#include "globals.h"
+#include <cstdint>
+#include <vector>
+
+class Game;
+
+const int MAXCELLS = 100; // the most cells a GameState board can have (10 x 10)
+static_assert(MAXCELLS <= 128, "a CellSet holds at most 128 cells");
+
+  // A set of cells, one bit per cell.  Cell r, c of a board with nCols
+  // columns is number r * nCols + c.
+class CellSet
+{
+  public:
+    CellSet() : m_bits{0, 0} {}
+    bool contains(int cell) const { return (m_bits[cell >> 6] >> (cell & 63)) & 1; }
+    void insert(int cell) { m_bits[cell >> 6] |= uint64_t(1) << (cell & 63); }
+    void erase(int cell) { m_bits[cell >> 6] &= ~(uint64_t(1) << (cell & 63)); }
+    bool empty() const { return (m_bits[0] | m_bits[1]) == 0; }
+    int size() const { return __builtin_popcountll(m_bits[0]) + __builtin_popcountll(m_bits[1]); }
+      // The lowest numbered cell in a set that isn't empty
+    int first() const { return m_bits[0] ? __builtin_ctzll(m_bits[0]) : 64 + __builtin_ctzll(m_bits[1]); }
+    CellSet operator&(const CellSet& other) const { return CellSet(m_bits[0] & other.m_bits[0], m_bits[1] & other.m_bits[1]); }
+    CellSet operator|(const CellSet& other) const { return CellSet(m_bits[0] | other.m_bits[0], m_bits[1] | other.m_bits[1]); }
+    CellSet without(const CellSet& other) const { return CellSet(m_bits[0] & ~other.m_bits[0], m_bits[1] & ~other.m_bits[1]); }
+    bool operator==(const CellSet& other) const { return m_bits[0] == other.m_bits[0] && m_bits[1] == other.m_bits[1]; }
+    uint64_t word(int i) const { return m_bits[i]; }
+    static CellSet fromWords(uint64_t lo, uint64_t hi) { return CellSet(lo, hi); }
+
+  private:
+    CellSet(uint64_t lo, uint64_t hi) : m_bits{lo, hi} {}
+    uint64_t m_bits[2];
+};
+
+  // One player's fleet and the shots fired at it
+struct SideState
+{
+    CellSet ships;               // cells with a ship on them
+    CellSet shots;               // cells that have been attacked
+    uint8_t shipAt[MAXCELLS];    // the id of the ship on each ship cell
+    uint8_t hitsLeft[MAXCELLS];  // per ship id, cells not yet hit
+    uint8_t shipsLeft;           // ships not yet destroyed
+};
+
+class GameStateJournal;
+
+  // Everything about a game in progress: both fleets, the shots fired at
+  // them, and whose turn it is.  A GameState is a plain value, so copying
+  // one branches the game.
+class GameState
+{
+  public:
+    GameState();
+    GameState(int nRows, int nCols);
+      // Return true if g's boards are small enough for a GameState
+    static bool fits(const Game& g);
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+    int cellOf(Point p) const { return p.r * m_cols + p.c; }
+    Point pointOf(int cell) const { return Point(cell / m_cols, cell % m_cols); }
+      // The side whose turn it is; it attacks side 1 - toMove()
+    int toMove() const { return m_toMove; }
+      // Give side s the next turn, for simulations where only one side attacks
+    void setToMove(int s) { m_toMove = s; }
+    const SideState& side(int s) const { return m_side[s]; }
+    bool placeShip(int s, Point topOrLeft, int shipId, int length, Direction dir);
+      // The side to move attacks p, then the turn passes to the other side.
+      // If journal isn't null, the attack is recorded so it can be undone.
+      // The results are set as Board::attack sets them.
+    bool attack(Point p, bool& shotHit, bool& shipDestroyed, int& shipId,
+                GameStateJournal* journal = nullptr);
+      // The same, for the cell numbered cellOf(p); any number off the board is
+      // an invalid shot
+    bool attack(Cell cell, bool& shotHit, bool& shipDestroyed, int& shipId,
+                GameStateJournal* journal = nullptr);
+      // The side to move fires a salvo at cells, marking them all shot with
+      // one set operation, then the turn passes; results is replaced with
+      // what became of each shot, and the number that hit is returned.
+      // Salvos aren't journaled.
+    int attackBatch(const std::vector<Cell>& cells, std::vector<ShotResult>& results);
+    bool allShipsDestroyed(int s) const { return m_side[s].shipsLeft == 0; }
+    void display(const Game& g, int s, bool shotsOnly) const;
+
+  private:
+    friend class GameStateJournal;
+    SideState m_side[2];
+    uint8_t m_rows;
+    uint8_t m_cols;
+    uint8_t m_toMove;
+};
+
+  // A record of attacks made on a GameState.  snapshot() marks a point in
+  // the game, and restore() undoes every attack made since then.
+class GameStateJournal
+{
+  public:
+    GameStateJournal() { m_entries.reserve(2 * MAXCELLS); }
+    int snapshot() const { return m_entries.size(); }
+    void restore(GameState& state, int mark);
+    void clear() { m_entries.clear(); }
+
+  private:
+    friend class GameState;
+    struct Entry
+    {
+        uint8_t attacker;
+        uint8_t cell;   // only meaningful if valid
+        uint8_t valid;
+        uint8_t shipId; // NOSHIP if the shot missed
+    };
+    static const uint8_t NOSHIP = 0xff;
+    std::vector<Entry> m_entries;
+};
+
+#endif // GAMESTATE_INCLUDED
@@ -0,0 +1,308 @@
+#include "LayoutCorpus.h"
+#include "Board.h"
+#include "Game.h"
+#include "GameState.h"
+#include "globals.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// A corpus file is a header followed by nLayouts records of recordSize
+// bytes.  A record is the two words of the CellSet its ships cover, then a
+// byte per ship id holding the cell of its top or left end, with the high
+// bit set if it is vertical, padded to a multiple of 8 bytes.  The file is
+// in the byte order of the machine that wrote it.
+
+struct CorpusHeader
+{
+    char magic[8];             // "BSLAYOUT"
+    uint32_t version;
+    uint16_t rows;
+    uint16_t cols;
+    uint32_t nShips;
+    uint32_t recordSize;
+    uint64_t nLayouts;
+    uint8_t lengths[MAXCELLS]; // per ship id
+};
+
+const char CORPUS_MAGIC[8] = {'B', 'S', 'L', 'A', 'Y', 'O', 'U', 'T'};
+const uint32_t CORPUS_VERSION = 1;
+const uint8_t VERTICAL_BIT = 0x80;
+
+// helper function
+// fill in the header for a corpus of g's layouts; return false if g can't have one
+bool makeHeader(const Game &g, CorpusHeader &header)
+{
+    if (!GameState::fits(g) || g.nShips() > MAXCELLS)
+        return false;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CORPUS_MAGIC, sizeof(header.magic));
+    header.version = CORPUS_VERSION;
+    header.rows = g.rows();
+    header.cols = g.cols();
+    header.nShips = g.nShips();
+    header.recordSize = (16 + g.nShips() + 7) / 8 * 8;
+    for (int k = 0; k < g.nShips(); k++)
+        header.lengths[k] = g.shipLength(k);
+    return true;
+}
+
+// helper function
+// write a corpus of nLayouts of g's layouts to path, getting layout i from
+// next(i, layout), which returns false if it has none; return false if g
+// doesn't fit or the file can't be written
+template <class Next>
+bool writeCorpus(const Game &g, const string &path, long nLayouts, Next next)
+{
+    CorpusHeader header;
+    if (!makeHeader(g, header) || nLayouts < 1 || nLayouts > INT32_MAX)
+        return false;
+    header.nLayouts = nLayouts;
+
+    // write to a temporary file and rename it, so nobody maps half a corpus
+    string tempPath = path + ".tmp";
+    ofstream out(tempPath, ios::binary | ios::trunc);
+    if (!out)
+        return false;
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    GameState blank(g.rows(), g.cols());
+    vector<ShipPlacement> layout;
+    vector<unsigned char> chunk;
+    chunk.reserve(4096 * header.recordSize);
+    for (long i = 0; i < nLayouts && out; i++)
+    {
+        if (!next(i, layout))
+        {
+            out.close();
+            remove(tempPath.c_str());
+            return false;
+        }
+        unsigned char record[16 + MAXCELLS + 8] = {};
+        CellSet covered;
+        for (int k = 0; k < g.nShips(); k++)
+        {
+            Point p = layout[k].topOrLeft;
+            for (int j = 0; j < g.shipLength(k); j++)
+                covered.insert(blank.cellOf(layout[k].dir == HORIZONTAL ? Point(p.r, p.c + j) : Point(p.r + j, p.c)));
+            record[16 + k] = blank.cellOf(p) | (layout[k].dir == VERTICAL ? VERTICAL_BIT : 0);
+        }
+        uint64_t words[2] = {covered.word(0), covered.word(1)};
+        memcpy(record, words, sizeof(words));
+        chunk.insert(chunk.end(), record, record + header.recordSize);
+        if (chunk.size() >= 4096 * header.recordSize || i + 1 == nLayouts)
+        {
+            out.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+            chunk.clear();
+        }
+    }
+    out.close();
+    if (!out || rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+class LayoutCorpusImpl
+{
+public:
+    LayoutCorpusImpl(const Game &g, const string &path);
+    ~LayoutCorpusImpl();
+    bool isOpen() const { return m_records != nullptr; }
+    bool fits(const Game &g) const;
+    long size() const { return m_size; }
+    CellSet cells(long i) const;
+    void layout(long i, vector<ShipPlacement> &layout) const;
+    bool placeShips(Board &b) const;
+
+private:
+    void *m_memory;
+    size_t m_mapped;
+    const CorpusHeader *m_header;
+    const unsigned char *m_records;
+    long m_size;
+    int m_recordSize;
+    int m_cols;
+    int m_nShips;
+};
+
+LayoutCorpusImpl::LayoutCorpusImpl(const Game &g, const string &path)
+    : m_memory(MAP_FAILED), m_mapped(0), m_header(nullptr), m_records(nullptr), m_size(0),
+      m_recordSize(0),
+      m_cols(g.cols()), m_nShips(g.nShips())
+{
+    CorpusHeader expected;
+    if (!makeHeader(g, expected))
+        return;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(CorpusHeader))
+    {
+        m_mapped = st.st_size;
+        m_memory = mmap(nullptr, m_mapped, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd); // the mapping keeps the file open
+    if (m_memory == MAP_FAILED)
+        return;
+
+    // use the file only if it was written for this board and fleet, in full
+    const CorpusHeader &header = *static_cast<const CorpusHeader *>(m_memory);
+    expected.nLayouts = header.nLayouts;
+    if (memcmp(&header, &expected, sizeof(header)) != 0 || header.nLayouts == 0 ||
+        header.nLayouts > uint64_t(INT32_MAX) ||
+        (m_mapped - sizeof(header)) / header.recordSize < header.nLayouts)
+        return;
+    m_header = &header;
+    m_records = static_cast<const unsigned char *>(m_memory) + sizeof(header);
+    m_size = header.nLayouts;
+    m_recordSize = header.recordSize;
+}
+
+LayoutCorpusImpl::~LayoutCorpusImpl()
+{
+    if (m_memory != MAP_FAILED)
+        munmap(m_memory, m_mapped);
+}
+
+bool LayoutCorpusImpl::fits(const Game &g) const
+{
+    if (!isOpen() || g.rows() != m_header->rows || g.cols() != m_header->cols ||
+        g.nShips() != int(m_header->nShips))
+        return false;
+    for (int k = 0; k < g.nShips(); k++)
+        if (g.shipLength(k) != m_header->lengths[k])
+            return false;
+    return true;
+}
+
+CellSet LayoutCorpusImpl::cells(long i) const
+{
+    const uint64_t *words = reinterpret_cast<const uint64_t *>(m_records + i * m_recordSize);
+    return CellSet::fromWords(words[0], words[1]);
+}
+
+void LayoutCorpusImpl::layout(long i, vector<ShipPlacement> &layout) const
+{
+    const unsigned char *ships = m_records + i * m_recordSize + 16;
+    layout.resize(m_nShips);
+    for (int k = 0; k < m_nShips; k++)
+    {
+        int cell = ships[k] & ~VERTICAL_BIT;
+        layout[k] = ShipPlacement{Point(cell / m_cols, cell % m_cols),
+                                  (ships[k] & VERTICAL_BIT) ? VERTICAL : HORIZONTAL};
+    }
+}
+
+bool LayoutCorpusImpl::placeShips(Board &b) const
+{
+    if (!isOpen())
+        return false;
+    const unsigned char *ships = m_records + long(randInt(m_size)) * m_recordSize + 16;
+    b.clear();
+    for (int k = 0; k < m_nShips; k++)
+    {
+        int cell = ships[k] & ~VERTICAL_BIT;
+        if (!b.placeShip(Point(cell / m_cols, cell % m_cols), k,
+                         (ships[k] & VERTICAL_BIT) ? VERTICAL : HORIZONTAL))
+            return false;
+    }
+    return true;
+}
+
+//******************** LayoutCorpus functions *************************
+
+// These functions simply delegate to LayoutCorpusImpl's functions.
+
+LayoutCorpus::LayoutCorpus(const Game &g, const string &path)
+{
+    m_impl = new LayoutCorpusImpl(g, path);
+}
+
+LayoutCorpus::~LayoutCorpus()
+{
+    delete m_impl;
+}
+
+bool LayoutCorpus::isOpen() const
+{
+    return m_impl->isOpen();
+}
+
+bool LayoutCorpus::fits(const Game &g) const
+{
+    return m_impl->fits(g);
+}
+
+long LayoutCorpus::size() const
+{
+    return m_impl->size();
+}
+
+CellSet LayoutCorpus::cells(long i) const
+{
+    return m_impl->cells(i);
+}
+
+void LayoutCorpus::layout(long i, vector<ShipPlacement> &layout) const
+{
+    m_impl->layout(i, layout);
+}
+
+bool LayoutCorpus::placeShips(Board &b) const
+{
+    return m_impl->placeShips(b);
+}
+
+bool LayoutCorpus::generate(const Game &g, const string &path, long nLayouts)
+{
+    const FleetSampler &sampler = FleetSampler::shared(g);
+    return writeCorpus(g, path, nLayouts,
+                       [&](long, vector<ShipPlacement> &layout) { return sampler.sample(layout); });
+}
+
+bool LayoutCorpus::write(const Game &g, const string &path,
+                         const vector<vector<ShipPlacement>> &layouts)
+{
+    return writeCorpus(g, path, layouts.size(), [&](long i, vector<ShipPlacement> &layout) {
+        layout = layouts[i];
+        return int(layout.size()) == g.nShips();
+    });
+}
+
+// The corpus openShared opened.  It is set before any game starts and never
+// changes while games run, so players read it without a lock.
+static LayoutCorpus *sharedCorpus = nullptr;
+
+bool LayoutCorpus::openShared(const Game &g, const string &path)
+{
+    delete sharedCorpus;
+    sharedCorpus = new LayoutCorpus(g, path);
+    if (sharedCorpus->isOpen())
+        return true;
+    delete sharedCorpus;
+    sharedCorpus = nullptr;
+    return false;
+}
+
+void LayoutCorpus::closeShared()
+{
+    delete sharedCorpus;
+    sharedCorpus = nullptr;
+}
+
+const LayoutCorpus *LayoutCorpus::shared(const Game &g)
+{
+    return sharedCorpus != nullptr && sharedCorpus->fits(g) ? sharedCorpus : nullptr;
+}
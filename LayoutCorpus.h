@@ -0,0 +1,63 @@
+#ifndef LAYOUTCORPUS_INCLUDED
+#define LAYOUTCORPUS_INCLUDED
+
+#include "FleetSampler.h"
+#include <string>
+#include <vector>
+
+class Game;
+class Board;
+class CellSet;
+class LayoutCorpusImpl;
+
+  // The file the corpus command writes unless told otherwise
+const char* const STANDARD_CORPUS_FILE = "layouts.bin";
+
+  // A LayoutCorpus is a file of fleet layouts for one board size and fleet,
+  // written once by generate and then mapped read-only into memory, so every
+  // process that opens it shares the same pages.  Each layout is a bitmask
+  // of the cells it covers followed by one byte per ship, and drawing one is
+  // a single random index.  Only boards that fit a GameState can have one.
+class LayoutCorpus
+{
+  public:
+      // Map the corpus in path if it was written for g's board and fleet
+    LayoutCorpus(const Game& g, const std::string& path);
+    ~LayoutCorpus();
+    bool isOpen() const;
+      // Return true if the corpus is open and was written for g's board and fleet
+    bool fits(const Game& g) const;
+    long size() const;
+      // The cells covered by layout i
+    CellSet cells(long i) const;
+      // Fill layout, indexed by ship id, with layout i
+    void layout(long i, std::vector<ShipPlacement>& layout) const;
+      // Clear b and place a layout picked with the active random engine on it
+    bool placeShips(Board& b) const;
+      // Write nLayouts layouts of g's fleet, drawn uniformly by a FleetSampler,
+      // to path; return false if g doesn't fit or the file can't be written
+    static bool generate(const Game& g, const std::string& path, long nLayouts);
+      // Write layouts, each indexed by ship id, to path as a corpus of g's
+      // fleet, such as a placement book of hand-picked layouts; return false
+      // if there are none, g doesn't fit or the file can't be written
+    static bool write(const Game& g, const std::string& path,
+                      const std::vector<std::vector<ShipPlacement>>& layouts);
+      // Make the corpus in path, written for g's board and fleet, the one
+      // GoodPlayers place from.  There is none unless this is called, and it
+      // must be called before any game starts.  Return false, leaving none,
+      // if path holds no corpus for g.
+    static bool openShared(const Game& g, const std::string& path);
+      // Go back to having no shared corpus; like openShared, only before
+      // any game starts
+    static void closeShared();
+      // Return the corpus openShared opened if it fits g, or nullptr
+    static const LayoutCorpus* shared(const Game& g);
+      // We prevent a LayoutCorpus object from being copied or assigned
+    LayoutCorpus(const LayoutCorpus&) = delete;
+    LayoutCorpus& operator=(const LayoutCorpus&) = delete;
+
+  private:
+    LayoutCorpusImpl* m_impl;
+};
+
+#endif // LAYOUTCORPUS_INCLUDED
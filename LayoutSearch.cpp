@@ -0,0 +1,355 @@
+#include "LayoutSearch.h"
+#include "Game.h"
+#include "GameState.h"
+#include "Player.h"
+#include "Trace.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Where one ship can go, and the cells it covers there
+struct ShipOption
+{
+    ShipPlacement placement;
+    CellSet cells;
+};
+
+// One annealing chain: its layout as an option per ship, and its own moves
+struct Chain
+{
+    vector<int> choice;
+    double shots;
+    RandomEngine engine;
+};
+
+class LayoutSearchImpl
+{
+public:
+    LayoutSearchImpl(int nRows, int nCols, bool (*addShips)(Game &), int nThreads);
+    int nThreads() const { return m_nThreads; }
+    bool setCache(const string &path);
+    vector<HardLayout> search(const string &attacker, const LayoutSearchSettings &settings,
+                              void (*report)(int step, double hardest));
+
+private:
+    // attack layout with attacker alone, seeded by game; return the shots
+    // it took to sink every ship, or 0 if the game could not be set up
+    int shotsToSink(const string &attacker, const vector<ShipPlacement> &layout, int game) const;
+    // score every layout of batch as its mean shots over games [first,
+    // first + nGames), playing only the layouts that aren't in the cache
+    vector<double> score(const string &attacker, const vector<vector<ShipPlacement>> &batch,
+                         int first, int nGames);
+    // the cache key of layout's games [first, first + nGames) against attacker
+    string key(const string &attacker, const string &layout, int first, int nGames) const;
+    int m_rows, m_cols;
+    bool (*m_addShips)(Game &);
+    int m_nThreads;
+    string m_board; // the board and fleet, so scores for other games don't mix
+    map<string, long> m_cache; // total shots
+    string m_cachePath;
+};
+
+LayoutSearchImpl::LayoutSearchImpl(int nRows, int nCols, bool (*addShips)(Game &), int nThreads)
+    : m_rows(nRows), m_cols(nCols), m_addShips(addShips), m_nThreads(nThreads)
+{
+    if (m_nThreads < 1)
+        m_nThreads = max(1u, thread::hardware_concurrency());
+    Game g(m_rows, m_cols);
+    m_addShips(g);
+    m_board = to_string(m_rows) + "x" + to_string(m_cols);
+    for (int k = 0; k < g.nShips(); k++)
+        m_board += (k == 0 ? "/" : ",") + to_string(g.shipLength(k));
+}
+
+bool LayoutSearchImpl::setCache(const string &path)
+{
+    // a line is a key, a tab, and the total shots, where a key is five
+    // fields separated by tabs, since player types may hold spaces
+    ifstream in(path);
+    string line;
+    while (getline(in, line))
+    {
+        size_t tab = line.rfind('\t');
+        if (tab == string::npos || tab + 1 == line.size())
+            return false;
+        m_cache[line.substr(0, tab)] = atol(line.c_str() + tab + 1);
+    }
+    if (in.bad())
+        return false;
+    ofstream out(path, ios::app);
+    if (!out)
+        return false;
+    m_cachePath = path;
+    return true;
+}
+
+string LayoutSearchImpl::key(const string &attacker, const string &layout, int first, int nGames) const
+{
+    return m_board + '\t' + attacker + '\t' + layout + '\t' + to_string(first) + '\t' + to_string(nGames);
+}
+
+int LayoutSearchImpl::shotsToSink(const string &attacker, const vector<ShipPlacement> &layout,
+                                  int game) const
+{
+    TraceSpan span("attackLayout");
+    Game g(m_rows, m_cols);
+    if (!m_addShips(g))
+        return 0;
+    seed_seq seeds{unsigned(game)};
+    RandomEngine engine(seeds);
+    RandomEngineScope scope(engine);
+    Player *p = createPlayer(attacker, attacker, g);
+    if (p == nullptr)
+        return 0;
+    int shots = ::shotsToSink(p, g, layout);
+    delete p;
+    return max(shots, 0);
+}
+
+vector<double> LayoutSearchImpl::score(const string &attacker, const vector<vector<ShipPlacement>> &batch,
+                                       int first, int nGames)
+{
+    TraceSpan span("scoreLayouts");
+    // the layouts nobody has attacked yet, once each even if several chains
+    // proposed the same one
+    vector<string> keys;
+    vector<int> fresh; // indexes into batch
+    map<string, int> listed;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        keys.push_back(key(attacker, LayoutSearch::layoutText(batch[i]), first, nGames));
+        if (m_cache.count(keys[i]) == 0 && listed.emplace(keys[i], i).second)
+            fresh.push_back(i);
+    }
+
+    // every game of every fresh layout is one job, so a batch keeps all the
+    // threads busy however few layouts it has
+    long nJobs = long(fresh.size()) * nGames;
+    vector<int> shots(nJobs);
+    atomic<long> next(0);
+    auto worker = [&]() {
+        for (long j = next++; j < nJobs; j = next++)
+            shots[j] = shotsToSink(attacker, batch[fresh[j / nGames]], first + int(j % nGames));
+    };
+    vector<thread> threads;
+    for (int t = 1; t < m_nThreads; t++)
+        threads.emplace_back(worker);
+    worker();
+    for (thread &th : threads)
+        th.join();
+
+    ofstream out;
+    if (!m_cachePath.empty())
+        out.open(m_cachePath, ios::app);
+    for (size_t f = 0; f < fresh.size(); f++)
+    {
+        long total = 0;
+        for (int game = 0; game < nGames; game++)
+            total += shots[f * nGames + game];
+        m_cache[keys[fresh[f]]] = total;
+        if (out)
+            out << keys[fresh[f]] << '\t' << total << '\n';
+    }
+
+    vector<double> means;
+    for (const string &k : keys)
+        means.push_back(double(m_cache[k]) / nGames);
+    return means;
+}
+
+vector<HardLayout> LayoutSearchImpl::search(const string &attacker, const LayoutSearchSettings &settings,
+                                            void (*report)(int step, double hardest))
+{
+    Game g(m_rows, m_cols);
+    if (!m_addShips(g) || !GameState::fits(g) || g.nShips() < 1)
+        return vector<HardLayout>();
+    {
+        Player *p = createPlayer(attacker, attacker, g);
+        bool ok = p != nullptr && !p->isHuman();
+        delete p;
+        if (!ok)
+            return vector<HardLayout>();
+    }
+    const int nShips = g.nShips();
+    const int nChains = max(1, settings.chains);
+    const int nGames = max(1, settings.gamesPerLayout);
+
+    // every place every ship can go, and which option each place is
+    GameState blank(m_rows, m_cols);
+    vector<vector<ShipOption>> options(nShips);
+    vector<vector<int>> optionAt(nShips, vector<int>(m_rows * m_cols * 2, -1));
+    for (int k = 0; k < nShips; k++)
+        for (Direction dir : {HORIZONTAL, VERTICAL})
+            for (int r = 0; r + (dir == VERTICAL ? g.shipLength(k) - 1 : 0) < m_rows; r++)
+                for (int c = 0; c + (dir == HORIZONTAL ? g.shipLength(k) - 1 : 0) < m_cols; c++)
+                {
+                    ShipOption opt{ShipPlacement{Point(r, c), dir}, CellSet()};
+                    for (int j = 0; j < g.shipLength(k); j++)
+                        opt.cells.insert(dir == HORIZONTAL ? blank.cellOf(Point(r, c + j))
+                                                           : blank.cellOf(Point(r + j, c)));
+                    optionAt[k][blank.cellOf(Point(r, c)) * 2 + dir] = options[k].size();
+                    options[k].push_back(opt);
+                }
+    auto layoutOf = [&](const vector<int> &choice) {
+        vector<ShipPlacement> layout;
+        for (int k = 0; k < nShips; k++)
+            layout.push_back(options[k][choice[k]].placement);
+        return layout;
+    };
+
+    // start every chain from a layout drawn uniformly
+    vector<Chain> chains(nChains);
+    vector<vector<ShipPlacement>> batch;
+    for (int i = 0; i < nChains; i++)
+    {
+        seed_seq seeds{settings.searchSeed, unsigned(i)};
+        chains[i].engine.seed(seeds);
+        RandomEngineScope scope(chains[i].engine);
+        vector<ShipPlacement> layout;
+        if (!FleetSampler::shared(g).sample(layout))
+            return vector<HardLayout>();
+        for (int k = 0; k < nShips; k++)
+            chains[i].choice.push_back(optionAt[k][blank.cellOf(layout[k].topOrLeft) * 2 + layout[k].dir]);
+        batch.push_back(layout);
+    }
+    vector<double> shots = score(attacker, batch, 0, nGames);
+    map<string, HardLayout> seen; // every layout scored, by its text
+    for (int i = 0; i < nChains; i++)
+    {
+        chains[i].shots = shots[i];
+        seen[LayoutSearch::layoutText(batch[i])] = HardLayout{batch[i], shots[i], 0};
+    }
+    double hardest = *max_element(shots.begin(), shots.end());
+
+    const int reportEvery = max(1, settings.steps / 10);
+    vector<vector<int>> proposals(nChains);
+    for (int step = 1; step <= settings.steps; step++)
+    {
+        // cool geometrically from the start temperature to the end one
+        double fraction = settings.steps > 1 ? double(step - 1) / (settings.steps - 1) : 1;
+        double start = max(1e-9, settings.startTemperature), end = max(1e-9, settings.endTemperature);
+        double temperature = start * pow(end / start, fraction);
+
+        // each chain moves one ship: half the time a step or a turn about
+        // its end, otherwise anywhere it fits
+        batch.clear();
+        for (int i = 0; i < nChains; i++)
+        {
+            Chain &chain = chains[i];
+            proposals[i] = chain.choice;
+            int k = uniform_int_distribution<>(0, nShips - 1)(chain.engine);
+            CellSet others;
+            for (int j = 0; j < nShips; j++)
+                if (j != k)
+                    others = others | options[j][chain.choice[j]].cells;
+            for (int attempt = 0; attempt < 100; attempt++)
+            {
+                int candidate;
+                if (uniform_int_distribution<>(0, 1)(chain.engine) == 0)
+                {
+                    ShipPlacement at = options[k][chain.choice[k]].placement;
+                    static const int dr[] = {-1, 1, 0, 0, 0}, dc[] = {0, 0, -1, 1, 0};
+                    int move = uniform_int_distribution<>(0, 4)(chain.engine);
+                    int r = at.topOrLeft.r + dr[move], c = at.topOrLeft.c + dc[move];
+                    Direction dir = move == 4 ? (at.dir == HORIZONTAL ? VERTICAL : HORIZONTAL) : at.dir;
+                    if (r < 0 || r >= m_rows || c < 0 || c >= m_cols)
+                        continue;
+                    candidate = optionAt[k][blank.cellOf(Point(r, c)) * 2 + dir];
+                }
+                else
+                    candidate = uniform_int_distribution<>(0, options[k].size() - 1)(chain.engine);
+                if (candidate >= 0 && candidate != chain.choice[k] &&
+                    (options[k][candidate].cells & others).empty())
+                {
+                    proposals[i][k] = candidate;
+                    break;
+                }
+            }
+            batch.push_back(layoutOf(proposals[i]));
+        }
+
+        shots = score(attacker, batch, 0, nGames);
+        for (int i = 0; i < nChains; i++)
+        {
+            Chain &chain = chains[i];
+            double delta = shots[i] - chain.shots;
+            if (delta >= 0 || uniform_real_distribution<>(0, 1)(chain.engine) < exp(delta / temperature))
+            {
+                chain.choice = proposals[i];
+                chain.shots = shots[i];
+            }
+            seen[LayoutSearch::layoutText(batch[i])] = HardLayout{batch[i], shots[i], 0};
+            hardest = max(hardest, shots[i]);
+        }
+        if (report != nullptr && (step % reportEvery == 0 || step == settings.steps))
+            report(step, hardest);
+    }
+
+    // the hardest layouts, scored again on attacks the search never saw,
+    // since the search favours layouts that were lucky on its own
+    vector<HardLayout> result;
+    for (const auto &entry : seen)
+        result.push_back(entry.second);
+    stable_sort(result.begin(), result.end(),
+                [](const HardLayout &a, const HardLayout &b) { return a.shots > b.shots; });
+    if (int(result.size()) > settings.keep)
+        result.resize(max(0, settings.keep));
+    batch.clear();
+    for (const HardLayout &hard : result)
+        batch.push_back(hard.layout);
+    if (!batch.empty())
+    {
+        shots = score(attacker, batch, nGames, nGames);
+        for (size_t i = 0; i < result.size(); i++)
+            result[i].validatedShots = shots[i];
+    }
+    return result;
+}
+
+//******************** LayoutSearch functions *************************
+
+// These functions simply delegate to LayoutSearchImpl's functions.
+
+LayoutSearch::LayoutSearch(int nRows, int nCols, bool (*addShips)(Game &), int nThreads)
+{
+    m_impl = new LayoutSearchImpl(nRows, nCols, addShips, nThreads);
+}
+
+LayoutSearch::~LayoutSearch()
+{
+    delete m_impl;
+}
+
+int LayoutSearch::nThreads() const
+{
+    return m_impl->nThreads();
+}
+
+bool LayoutSearch::setCache(const string &path)
+{
+    return m_impl->setCache(path);
+}
+
+vector<HardLayout> LayoutSearch::search(const string &attacker, const LayoutSearchSettings &settings,
+                                        void (*report)(int step, double hardest))
+{
+    return m_impl->search(attacker, settings, report);
+}
+
+string LayoutSearch::layoutText(const vector<ShipPlacement> &layout)
+{
+    string text;
+    for (size_t k = 0; k < layout.size(); k++)
+        text += (k == 0 ? "" : "/") + to_string(layout[k].topOrLeft.r) + "," +
+                to_string(layout[k].topOrLeft.c) + (layout[k].dir == HORIZONTAL ? ",h" : ",v");
+    return text;
+}
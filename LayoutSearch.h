@@ -0,0 +1,65 @@
+#ifndef LAYOUTSEARCH_INCLUDED
+#define LAYOUTSEARCH_INCLUDED
+
+#include "FleetSampler.h"
+#include <string>
+#include <vector>
+
+class Game;
+class LayoutSearchImpl;
+
+struct LayoutSearchSettings
+{
+    int chains = 8;                // annealing chains run side by side
+    int steps = 200;               // moves each chain tries
+    int gamesPerLayout = 100;      // seeded attacks every candidate is scored on
+    double startTemperature = 2.0; // in shots; how much worse a move may be early on
+    double endTemperature = 0.05;  // and at the last step
+    int keep = 20;                 // how many of the hardest layouts to return
+    unsigned searchSeed = 1;       // seeds the chains' moves, not the attacks
+};
+
+  // One of the hardest layouts a search found
+struct HardLayout
+{
+    std::vector<ShipPlacement> layout; // indexed by ship id
+    double shots;          // mean shots to sink it over the search's attacks
+    double validatedShots; // the same over as many attacks the search never saw
+};
+
+  // A LayoutSearch looks for the fleet layouts an attacker needs the most
+  // shots to sink, by simulated annealing.  Each chain moves one ship at a
+  // time, checking overlaps with bitmasks, and every step the candidates of
+  // all the chains are attacked together as one batch spread over the
+  // threads.  Every candidate faces the same seeded attacks, and a layout's
+  // score can be kept in a file, so no layout is attacked twice.
+class LayoutSearch
+{
+  public:
+      // Every game is played on an nRows by nCols board set up by addShips.
+      // nThreads == 0 uses one thread per hardware core.
+    LayoutSearch(int nRows, int nCols, bool (*addShips)(Game&), int nThreads = 0);
+    ~LayoutSearch();
+    int nThreads() const;
+      // Read the scores already in path and add new ones to it from now on;
+      // return false if it exists but can't be read, or can't be written
+    bool setCache(const std::string& path);
+      // Search for the layouts attacker finds hardest, hardest first,
+      // calling report (if it isn't null) with the step and the hardest
+      // score so far every tenth of the way.  The result is empty if the
+      // board is too big for a GameState or attacker can't be made.
+    std::vector<HardLayout> search(const std::string& attacker,
+                                   const LayoutSearchSettings& settings,
+                                   void (*report)(int step, double hardest) = nullptr);
+      // Return layout written as r,c,h/r,c,v/... with one ship per entry,
+      // the way the placement command reads it
+    static std::string layoutText(const std::vector<ShipPlacement>& layout);
+      // We prevent a LayoutSearch object from being copied or assigned
+    LayoutSearch(const LayoutSearch&) = delete;
+    LayoutSearch& operator=(const LayoutSearch&) = delete;
+
+  private:
+    LayoutSearchImpl* m_impl;
+};
+
+#endif // LAYOUTSEARCH_INCLUDED
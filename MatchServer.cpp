@@ -0,0 +1,771 @@
+#include "MatchServer.h"
+#include "Board.h"
+#include "FleetSampler.h"
+#include "Game.h"
+#include "Player.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// A MatchServer speaks a line protocol that a person can type into nc as
+// easily as a bot can.  A connection plays one game at a time.
+//
+//   client -> server
+//     play <type>               a game against a computer player of that type;
+//                               the server places your fleet, and you move first
+//     shot <r> <c>              your move
+//     watch <type> <type>       a game between two computer players
+//     quit
+//
+//   server -> client
+//     hello <rows> <cols>       when you connect
+//     ship <id> <r> <c> <h|v>   one line per ship of the fleet placed for you
+//     turn                      it is your move
+//     you <r> <c> <outcome>     what your shot did: miss, hit, sank <id> or wasted
+//     they <r> <c> <outcome>    what the computer's shot did
+//     win <shots>               you sank the computer's fleet in that many shots
+//     lose <shots>              it sank yours; shots is how many you fired
+//     result <winner> <shots> <shots>   the end of a watched game; winner is
+//                               first, second or none, then each side's shots
+//     error <message>           the line was ignored
+//
+// Lines that arrive while the computer is thinking wait until it has moved.
+// A wasted shot (off the board or at a cell already attacked) still uses up
+// the turn, as in every other game.
+
+// What a connection is doing
+enum SessionState : uint8_t {
+    IDLE,    // no game
+    PLAYING, // waiting for the client's shot
+    WORKING  // a worker has the session
+};
+
+// A seat at a played game.  The client's seat fires whatever shot the
+// client sent last and places the fleet the server drew for it; the
+// computer's seat passes everything on to the player it owns.  Both remember
+// their last shot and what it did, for the lines that report it.
+class Seat : public Player
+{
+public:
+    Seat(const Game &g, const vector<ShipPlacement> &layout)
+        : Player("client", g), m_player(nullptr), m_layout(layout), m_shot(-1, -1)
+    {
+    }
+    Seat(Player *p, const Game &g) : Player(p->name(), g), m_player(p), m_shot(-1, -1) {}
+    virtual ~Seat() { delete m_player; }
+    virtual bool placeShips(Board &b)
+    {
+        if (m_player != nullptr)
+            return m_player->placeShips(b);
+        for (size_t k = 0; k < m_layout.size(); k++)
+            if (!b.placeShip(m_layout[k].topOrLeft, k, m_layout[k].dir))
+                return false;
+        return true;
+    }
+    virtual Point recommendAttack()
+    {
+        if (m_player != nullptr)
+            m_shot = m_player->recommendAttack();
+        return m_shot;
+    }
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p)
+    {
+        if (m_player != nullptr)
+            m_player->recordAttackByOpponent(p);
+    }
+    virtual bool hasForfeited() const { return m_player != nullptr && m_player->hasForfeited(); }
+      // the client's next shot
+    void aim(Point p) { m_shot = p; }
+    Point lastShot() const { return m_shot; }
+      // what the last shot did, unless it won the game, which the player
+      // isn't told about
+    const string &lastOutcome() const { return m_outcome; }
+
+private:
+    Player *m_player;
+    vector<ShipPlacement> m_layout;
+    Point m_shot;
+    string m_outcome;
+};
+
+// One connection.  While it is WORKING, only the worker touches seats, game,
+// stats and reply; the event loop only reads into in and writes out.
+struct Session
+{
+    int fd;
+    SessionState state;
+    atomic<bool> closed; // the connection is gone; free it when the worker is done
+    Player *seats[2];  // the first mover's and the second's: in a play, Seats for the
+                       // client and the computer
+    GameSession *game; // null while IDLE
+    GameStats stats;   // what each seat has done in game
+    string in;         // received, not yet handled
+    string out;        // waiting to be sent
+    string reply;      // written by the worker, sent when it is done
+};
+
+// Work for the pool
+struct Job
+{
+    enum Kind {
+        START, // place both fleets for a play
+        MOVE,  // the computer's turn
+        WATCH  // a step of a game between two computer players, the first
+               // of which starts it
+    };
+    Kind kind;
+    Session *session;
+    string first;
+    string second;
+};
+
+class MatchServerImpl
+{
+public:
+    MatchServerImpl(int nRows, int nCols, bool (*addShips)(Game &), int nWorkers);
+    ~MatchServerImpl();
+    bool listen(const string &address);
+    bool run();
+    void stop();
+    int nSessions() const { return m_nSessions; }
+
+private:
+    // the event loop's side
+    void acceptAll();
+    void readFrom(Session *s);
+    bool flushOut(Session *s);
+    void handleLines(Session *s);
+    bool handleLine(Session *s, const string &line);
+    void clientShot(Session *s, int r, int c);
+    void submit(Job job);
+    bool begin(Session *s, Player *first, Player *second);
+    void endGame(Session *s);
+    void finishJobs();
+    void closeSession(Session *s);
+    void deleteSession(Session *s);
+    bool isComputerType(const string &type) const;
+    // the workers' side
+    void worker();
+    void start(Session *s, const string &type);
+    void computerMove(Session *s);
+    bool watch(Session *s, const string &first, const string &second);
+
+    Game m_game;
+    bool m_ready;              // the fleet was added
+    vector<string> m_types;    // what play and watch accept
+    int m_epoll;
+    int m_wake;                // an eventfd workers bump when a job is done
+    int m_listen;
+    string m_unixPath;         // to unlink when we're done
+    atomic<bool> m_stopping;
+    vector<Session *> m_byFd;  // the open sessions, by file descriptor
+    vector<Session *> m_orphans; // closed while a worker had them
+    int m_nSessions;
+
+    mutex m_lock;              // guards the rest
+    condition_variable m_work;
+    deque<Job> m_jobs;
+    vector<Session *> m_done;
+    bool m_quit;
+    vector<thread> m_workers;
+};
+
+MatchServerImpl::MatchServerImpl(int nRows, int nCols, bool (*addShips)(Game &), int nWorkers)
+    : m_game(nRows, nCols), m_epoll(-1), m_wake(-1), m_listen(-1), m_stopping(false),
+      m_nSessions(0), m_quit(false)
+{
+    m_ready = addShips(m_game);
+    for (const string &type : computerPlayerTypes())
+        m_types.push_back(type);
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll >= 0 && m_wake >= 0)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = m_wake;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &ev);
+    }
+    if (nWorkers < 1)
+        nWorkers = max(1u, thread::hardware_concurrency());
+    for (int i = 0; i < nWorkers; i++)
+        m_workers.emplace_back(&MatchServerImpl::worker, this);
+}
+
+MatchServerImpl::~MatchServerImpl()
+{
+    {
+        lock_guard<mutex> guard(m_lock);
+        m_quit = true;
+    }
+    m_work.notify_all();
+    for (thread &w : m_workers)
+        w.join();
+    // every session is now either open or orphaned, and none is working
+    for (Session *s : m_byFd)
+        if (s != nullptr)
+        {
+            close(s->fd);
+            deleteSession(s);
+        }
+    for (Session *s : m_orphans)
+        deleteSession(s);
+    if (m_listen >= 0)
+        close(m_listen);
+    if (!m_unixPath.empty())
+        unlink(m_unixPath.c_str());
+    if (m_wake >= 0)
+        close(m_wake);
+    if (m_epoll >= 0)
+        close(m_epoll);
+}
+
+bool MatchServerImpl::listen(const string &address)
+{
+    if (!m_ready || m_epoll < 0 || m_wake < 0 || m_listen >= 0)
+        return false;
+    int fd = -1;
+    if (address.compare(0, 5, "unix:") == 0)
+    {
+        string path = address.substr(5);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+            return false;
+        strcpy(addr.sun_path, path.c_str());
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(path.c_str()); // a socket left over from an earlier run
+        if (fd < 0 || bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+        m_unixPath = path;
+    }
+    else if (address.compare(0, 4, "tcp:") == 0)
+    {
+        int port = atoi(address.c_str() + 4);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // local players only
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int yes = 1;
+        if (fd < 0 || port <= 0 || port > 65535 ||
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) != 0 ||
+            bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0)
+        {
+            if (fd >= 0)
+                close(fd);
+            return false;
+        }
+    }
+    else
+        return false;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (::listen(fd, SOMAXCONN) != 0 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    m_listen = fd;
+    return true;
+}
+
+bool MatchServerImpl::run()
+{
+    if (m_epoll < 0)
+        return false;
+    epoll_event events[256];
+    while (!m_stopping)
+    {
+        int n = epoll_wait(m_epoll, events, 256, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            int fd = events[i].data.fd;
+            if (fd == m_listen)
+                acceptAll();
+            else if (fd == m_wake)
+                finishJobs();
+            else if (fd < int(m_byFd.size()) && m_byFd[fd] != nullptr)
+            {
+                Session *s = m_byFd[fd];
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                {
+                    closeSession(s);
+                    continue;
+                }
+                if ((events[i].events & EPOLLOUT) && !flushOut(s))
+                    continue;
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP))
+                    readFrom(s);
+            }
+        }
+    }
+    return true;
+}
+
+void MatchServerImpl::stop()
+{
+    m_stopping = true;
+    uint64_t one = 1;
+    if (write(m_wake, &one, sizeof(one)) < 0) // wake epoll_wait up
+        return;
+}
+
+// helper function
+// take every connection waiting on the listening socket
+void MatchServerImpl::acceptAll()
+{
+    while (true)
+    {
+        int fd = accept4(m_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+            return; // EAGAIN, or out of descriptors until someone leaves
+        Session *s = new Session();
+        s->fd = fd;
+        s->state = IDLE;
+        s->closed = false;
+        s->seats[0] = s->seats[1] = nullptr;
+        s->game = nullptr;
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0)
+        {
+            close(fd);
+            delete s;
+            continue;
+        }
+        if (fd >= int(m_byFd.size()))
+            m_byFd.resize(fd + 1, nullptr);
+        m_byFd[fd] = s;
+        m_nSessions++;
+        s->out = "hello " + to_string(m_game.rows()) + " " + to_string(m_game.cols()) + "\n";
+        flushOut(s);
+    }
+}
+
+// helper function
+// read what the client sent and act on every complete line
+void MatchServerImpl::readFrom(Session *s)
+{
+    char buf[4096];
+    while (true)
+    {
+        ssize_t n = recv(s->fd, buf, sizeof(buf), 0);
+        if (n > 0)
+        {
+            s->in.append(buf, n);
+            if (s->in.size() > 4 * sizeof(buf)) // nobody needs lines that long
+            {
+                closeSession(s);
+                return;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n < 0 && errno == EINTR)
+            continue;
+        closeSession(s); // the client hung up
+        return;
+    }
+    handleLines(s);
+}
+
+// helper function
+// send as much of s->out as the socket takes, and ask to hear when it can
+// take more; return false if the connection failed and s is gone
+bool MatchServerImpl::flushOut(Session *s)
+{
+    size_t sent = 0;
+    while (sent < s->out.size())
+    {
+        // MSG_NOSIGNAL so a client that left doesn't kill us with SIGPIPE
+        ssize_t n = send(s->fd, s->out.data() + sent, s->out.size() - sent, MSG_NOSIGNAL);
+        if (n > 0)
+            sent += n;
+        else if (n < 0 && errno == EINTR)
+            continue;
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        else
+        {
+            closeSession(s);
+            return false;
+        }
+    }
+    s->out.erase(0, sent);
+    epoll_event ev{};
+    ev.events = uint32_t(EPOLLIN | EPOLLRDHUP) | (s->out.empty() ? 0u : uint32_t(EPOLLOUT));
+    ev.data.fd = s->fd;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, s->fd, &ev);
+    return true;
+}
+
+// helper function
+// act on complete lines until there are none or a worker takes the session
+void MatchServerImpl::handleLines(Session *s)
+{
+    size_t end;
+    while (s->state != WORKING && (end = s->in.find('\n')) != string::npos)
+    {
+        string line = s->in.substr(0, end);
+        s->in.erase(0, end + 1);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (!handleLine(s, line))
+            return;
+    }
+    flushOut(s);
+}
+
+// helper function
+// act on one line from the client; return false if it closed the session
+bool MatchServerImpl::handleLine(Session *s, const string &line)
+{
+    istringstream words(line);
+    string command;
+    words >> command;
+    if (command.empty())
+        return true;
+    if (command == "quit")
+    {
+        closeSession(s);
+        return false;
+    }
+    if (command == "shot")
+    {
+        int r, c;
+        if (s->state != PLAYING)
+            s->out += "error no game in progress\n";
+        else if (!(words >> r >> c))
+            s->out += "error usage: shot <r> <c>\n";
+        else
+            clientShot(s, r, c);
+        return true;
+    }
+    if (command != "play" && command != "watch")
+    {
+        s->out += "error unknown command " + command + "\n";
+        return true;
+    }
+    if (s->state == PLAYING)
+    {
+        s->out += "error finish this game first\n";
+        return true;
+    }
+    string first, second;
+    if (command == "play" && (words >> first) && isComputerType(first))
+        submit(Job{Job::START, s, first, ""});
+    else if (command == "watch" && (words >> first >> second) && isComputerType(first) &&
+             isComputerType(second))
+        submit(Job{Job::WATCH, s, first, second});
+    else
+        s->out += "error unknown player type\n";
+    return true;
+}
+
+// helper function
+// describe what a shot did
+string outcome(bool valid, bool hit, bool destroyed, int shipId)
+{
+    if (!valid)
+        return "wasted";
+    if (destroyed)
+        return "sank " + to_string(shipId);
+    return hit ? "hit" : "miss";
+}
+
+void Seat::recordAttackResult(Point p, bool validShot, bool shotHit, bool shipDestroyed, int shipId)
+{
+    m_outcome = outcome(validShot, shotHit, shipDestroyed, shipId);
+    if (m_player != nullptr)
+        m_player->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+}
+
+// helper function
+// the line reporting seat side's last shot in s's game, which prefix begins
+string shotLine(const Session *s, int side, const char *prefix)
+{
+    const Seat *seat = static_cast<const Seat *>(s->seats[side]);
+    Point p = seat->lastShot();
+    return string(prefix) + " " + to_string(p.r) + " " + to_string(p.c) + " " +
+           (s->game->isOver() ? "sank " + to_string(s->stats.sunk[side].back()) : seat->lastOutcome()) +
+           "\n";
+}
+
+// helper function
+// the client attacks (r, c); then, unless that won, the computer moves
+void MatchServerImpl::clientShot(Session *s, int r, int c)
+{
+    static_cast<Seat *>(s->seats[0])->aim(Point(r, c));
+    s->game->step();
+    s->out += shotLine(s, 0, "you");
+    if (s->game->isOver())
+    {
+        s->out += "win " + to_string(s->stats.shots[0]) + "\n";
+        endGame(s);
+        s->state = IDLE;
+        return;
+    }
+    submit(Job{Job::MOVE, s, "", ""});
+}
+
+void MatchServerImpl::submit(Job job)
+{
+    job.session->state = WORKING;
+    {
+        lock_guard<mutex> guard(m_lock);
+        m_jobs.push_back(move(job));
+    }
+    m_work.notify_one();
+}
+
+// helper function
+// seat first and second at a new game for s and place their fleets; return
+// false, with s left without a game, if either can't place
+bool MatchServerImpl::begin(Session *s, Player *first, Player *second)
+{
+    s->seats[0] = first;
+    s->seats[1] = second;
+    s->game = new GameSession(m_game, first, second, false, false, &s->stats);
+    if (!s->game->step())
+    {
+        endGame(s);
+        return false;
+    }
+    return true;
+}
+
+void MatchServerImpl::endGame(Session *s)
+{
+    delete s->game;
+    delete s->seats[0];
+    delete s->seats[1];
+    s->game = nullptr;
+    s->seats[0] = s->seats[1] = nullptr;
+}
+
+// helper function
+// hand the sessions workers have finished with back to their clients
+void MatchServerImpl::finishJobs()
+{
+    uint64_t count;
+    if (read(m_wake, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        return;
+    vector<Session *> done;
+    {
+        lock_guard<mutex> guard(m_lock);
+        done.swap(m_done);
+    }
+    for (Session *s : done)
+    {
+        if (s->closed)
+        {
+            m_orphans.erase(find(m_orphans.begin(), m_orphans.end(), s));
+            deleteSession(s);
+            continue;
+        }
+        s->state = s->game != nullptr ? PLAYING : IDLE;
+        s->out += s->reply;
+        s->reply.clear();
+        handleLines(s); // anything the client sent meanwhile
+    }
+}
+
+void MatchServerImpl::closeSession(Session *s)
+{
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, s->fd, nullptr);
+    close(s->fd);
+    m_byFd[s->fd] = nullptr;
+    m_nSessions--;
+    if (s->state == WORKING) // the worker still has it
+    {
+        s->closed = true;
+        m_orphans.push_back(s);
+    }
+    else
+        deleteSession(s);
+}
+
+void MatchServerImpl::deleteSession(Session *s)
+{
+    endGame(s);
+    delete s;
+}
+
+bool MatchServerImpl::isComputerType(const string &type) const
+{
+    return find(m_types.begin(), m_types.end(), type) != m_types.end();
+}
+
+void MatchServerImpl::worker()
+{
+    while (true)
+    {
+        Job job;
+        {
+            unique_lock<mutex> guard(m_lock);
+            m_work.wait(guard, [this] { return m_quit || !m_jobs.empty(); });
+            if (m_quit)
+                return;
+            job = move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        Session *s = job.session;
+        bool again = false;
+        if (!s->closed)
+        {
+            if (job.kind == Job::START)
+                start(s, job.first);
+            else if (job.kind == Job::MOVE)
+                computerMove(s);
+            else
+                again = watch(s, job.first, job.second);
+        }
+        {
+            lock_guard<mutex> guard(m_lock);
+            if (again) // behind whatever was queued meanwhile, so no game hogs a worker
+            {
+                m_jobs.push_back(move(job));
+                continue;
+            }
+            m_done.push_back(s);
+        }
+        uint64_t one = 1;
+        if (write(m_wake, &one, sizeof(one)) < 0)
+            continue; // the counter is full, so the loop is waking up anyway
+    }
+}
+
+// helper function
+// set up a game between the client and a computer player of type
+void MatchServerImpl::start(Session *s, const string &type)
+{
+    Player *ai = createPlayer(type, type, m_game);
+    vector<ShipPlacement> layout;
+    if (ai == nullptr || !FleetSampler::shared(m_game).sample(layout))
+    {
+        delete ai;
+        s->reply = "error could not place the fleets\n";
+        return;
+    }
+    if (!begin(s, new Seat(m_game, layout), new Seat(ai, m_game)))
+    {
+        s->reply = "error could not place the fleets\n";
+        return;
+    }
+    for (int k = 0; k < m_game.nShips(); k++)
+    {
+        const ShipPlacement &pl = layout[k];
+        s->reply += "ship " + to_string(k) + " " + to_string(pl.topOrLeft.r) + " " +
+                    to_string(pl.topOrLeft.c) + (pl.dir == HORIZONTAL ? " h\n" : " v\n");
+    }
+    s->reply += "turn\n";
+}
+
+// helper function
+// the computer attacks the client's fleet
+void MatchServerImpl::computerMove(Session *s)
+{
+    s->game->step();
+    s->reply = shotLine(s, 1, "they");
+    if (s->game->isOver())
+    {
+        s->reply += "lose " + to_string(s->stats.shots[0]) + "\n";
+        endGame(s);
+        return;
+    }
+    s->reply += "turn\n";
+}
+
+// helper function
+// take one step of a game between two computer players, starting the game
+// if s has none; return true if there are more steps to take
+bool MatchServerImpl::watch(Session *s, const string &first, const string &second)
+{
+    if (s->game == nullptr)
+    {
+        Player *p1 = createPlayer(first, first, m_game);
+        Player *p2 = createPlayer(second, second, m_game);
+        if (begin(s, p1, p2)) // a game with a missing player never starts
+            return true;
+        s->reply = "result none 0 0\n";
+        return false;
+    }
+    if (s->game->step())
+        return true;
+    Player *winner = s->game->winner();
+    s->reply = string("result ") + (winner == nullptr ? "none" : winner == s->seats[0] ? "first" : "second") +
+               " " + to_string(s->stats.shots[0]) + " " + to_string(s->stats.shots[1]) + "\n";
+    endGame(s);
+    return false;
+}
+
+//******************** MatchServer functions ********************************
+
+// These functions simply delegate to MatchServerImpl's functions.
+
+MatchServer::MatchServer(int nRows, int nCols, bool (*addShips)(Game &), int nWorkers)
+{
+    m_impl = new MatchServerImpl(nRows, nCols, addShips, nWorkers);
+}
+
+MatchServer::~MatchServer()
+{
+    delete m_impl;
+}
+
+bool MatchServer::listen(const string &address)
+{
+    return m_impl->listen(address);
+}
+
+bool MatchServer::run()
+{
+    return m_impl->run();
+}
+
+void MatchServer::stop()
+{
+    m_impl->stop();
+}
+
+int MatchServer::nSessions() const
+{
+    return m_impl->nSessions();
+}
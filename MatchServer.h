@@ -0,0 +1,38 @@
+#ifndef MATCHSERVER_INCLUDED
+#define MATCHSERVER_INCLUDED
+
+#include <string>
+
+class Game;
+class MatchServerImpl;
+
+  // A MatchServer hosts many games at once over a local socket.  One thread
+  // runs an epoll loop over every connection, and computer moves are handed
+  // to a pool of worker threads, so a slow player never holds up the others.
+  // The line protocol is described at the top of MatchServer.cpp.
+class MatchServer
+{
+  public:
+      // Every game is played on an nRows by nCols board set up by addShips.
+      // nWorkers == 0 uses one worker per hardware core.
+    MatchServer(int nRows, int nCols, bool (*addShips)(Game&), int nWorkers = 0);
+    ~MatchServer();
+      // Listen on "unix:<path>" or "tcp:<port>" (on the loopback address);
+      // return false if that can't be done
+    bool listen(const std::string& address);
+      // Serve connections until stop is called; return false if the event
+      // loop failed
+    bool run();
+      // Make run return soon; this may be called from any thread
+    void stop();
+      // The number of connections open right now
+    int nSessions() const;
+      // We prevent a MatchServer object from being copied or assigned
+    MatchServer(const MatchServer&) = delete;
+    MatchServer& operator=(const MatchServer&) = delete;
+
+  private:
+    MatchServerImpl* m_impl;
+};
+
+#endif // MATCHSERVER_INCLUDED
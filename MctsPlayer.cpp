@@ -0,0 +1,515 @@
+#include "Player.h"
+#include "Board.h"
+#include "CellGrid.h"
+#include "FixedGame.h"
+#include "Game.h"
+#include "GameState.h"
+#include "OpeningBook.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//*********************************************************************
+//  MctsPlayer
+//*********************************************************************
+
+// An MctsPlayer searches for its next shot with Monte Carlo tree search.  At
+// the start of each move it samples a pool of opponent fleets that agree with
+// everything it has seen so far.  Each iteration then takes one of them,
+// walks down a tree of shot sequences that all the worker threads share,
+// and plays the game out from there with a quick hunt-and-target policy.
+// The fewer shots the playout needs to sink the fleet, the better the path
+// scores.  The tree's counters are atomics, so threads update it without
+// locks, and a thread's visit to a node counts as a loss until its result
+// arrives, which spreads the threads over different branches.  The search is
+// templated on the shape of the game, so for the standard game (a
+// StandardGame) the board size and ship lengths are compile-time constants.
+// Until it sinks a ship, it plays from the opening book a book command
+// opened (see OpeningBook.h), if there is one for the game.
+
+// A way to place a ship, as the cells it covers
+struct Placement
+{
+    CellSet cells;
+    Point topOrLeft;
+    Direction dir;
+};
+
+class MctsPlayer : public Player
+{
+public:
+    MctsPlayer(string nm, const Game &g, int iterations, int nThreads, int msPerMove, bool useBook);
+    virtual bool placeShips(Board &b);
+    virtual Point recommendAttack();
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponent(Point p);
+    virtual bool attacksByCell() const { return true; }
+    virtual int recommendAttackCell();
+    virtual void recordAttackResultAt(int cell, bool validShot, bool shotHit,
+                                      bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponentAt(int /* cell */) {}
+
+private:
+    struct Node
+    {
+        atomic<int> visits;
+        atomic<long long> value; // sum of playout scores, in millionths
+        atomic<Node *> child[MAXCELLS];
+    };
+    template <class Shape>
+    int chooseCell(Shape shape);
+    template <class Shape>
+    bool sampleFleet(GameState &sample, Shape shape) const;
+    template <class Shape>
+    bool choosePlacement(int shipId, int mustCover, const CellSet &occupied, int &chosen,
+                         Shape shape) const;
+    template <class Shape>
+    int rollout(GameState &state, Shape shape) const;
+    template <class Shape>
+    void searchWorker(unsigned seed, chrono::steady_clock::time_point deadline, Shape shape);
+    Node *newNode();
+    int m_iterations;
+    int m_nThreads;
+    int m_msPerMove;
+    bool m_useBook;                          // play from OpeningBook::shared
+    bool m_standard;                         // the game is a StandardGame
+    vector<vector<Placement>> m_placements;  // per ship length
+    vector<vector<vector<int>>> m_covering;  // per ship length and cell, placements covering it
+    CellSet m_shots;                         // what we have seen of the opponent's board
+    CellSet m_hits;
+    vector<int> m_sunkAt;                    // per ship id, the cell that sank it or -1
+    // the search of the current move
+    vector<GameState> m_pool;
+    vector<double> m_prior;
+    unique_ptr<Node[]> m_nodes;
+    int m_nNodes;
+    atomic<int> m_nodesUsed;
+    atomic<int> m_iterationsLeft;
+};
+
+MctsPlayer::MctsPlayer(string nm, const Game &g, int iterations, int nThreads, int msPerMove,
+                       bool useBook)
+    : Player(nm, g), m_iterations(max(1, iterations)), m_nThreads(max(1, nThreads)),
+      m_msPerMove(msPerMove), m_useBook(useBook), m_standard(StandardGame::matches(g)),
+      m_sunkAt(g.nShips(), -1), m_prior(MAXCELLS),
+      m_nNodes(m_iterations + m_nThreads + 1), m_nodesUsed(0), m_iterationsLeft(0)
+{
+    // list every way to place a ship of each length
+    int longest = 0;
+    for (int k = 0; k < g.nShips(); k++)
+        longest = max(longest, g.shipLength(k));
+    m_placements.resize(longest + 1);
+    m_covering.assign(longest + 1, vector<vector<int>>(MAXCELLS));
+    GameState blank(g.rows(), g.cols());
+    for (int len = 1; len <= longest; len++)
+    {
+        for (int r = 0; r < g.rows(); r++)
+        {
+            for (int c = 0; c < g.cols(); c++)
+            {
+                for (Direction dir : {HORIZONTAL, VERTICAL})
+                {
+                    if ((dir == HORIZONTAL && c + len > g.cols()) || (dir == VERTICAL && r + len > g.rows()))
+                        continue;
+                    if (len == 1 && dir == VERTICAL) // a one cell ship only needs one direction
+                        continue;
+                    Placement pl{CellSet(), Point(r, c), dir};
+                    for (int i = 0; i < len; i++)
+                        pl.cells.insert(blank.cellOf(dir == HORIZONTAL ? Point(r, c + i) : Point(r + i, c)));
+                    for (CellSet rest = pl.cells; !rest.empty(); rest.erase(rest.first()))
+                        m_covering[len][rest.first()].push_back(m_placements[len].size());
+                    m_placements[len].push_back(pl);
+                }
+            }
+        }
+    }
+    m_pool.reserve(256);
+    m_nodes.reset(new Node[m_nNodes]);
+}
+
+bool MctsPlayer::placeShips(Board &b)
+{
+    // random positions, starting over whenever a ship doesn't fit
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        b.clear();
+        int k;
+        for (k = 0; k < game().nShips(); k++)
+        {
+            const vector<Placement> &options = m_placements[game().shipLength(k)];
+            int tries;
+            for (tries = 0; tries < 100; tries++)
+            {
+                const Placement &pl = options[randInt(options.size())];
+                if (b.placeShip(pl.topOrLeft, k, pl.dir))
+                    break;
+            }
+            if (tries == 100)
+                break;
+        }
+        if (k == game().nShips())
+            return true;
+    }
+    return false;
+}
+
+void MctsPlayer::recordAttackByOpponent(Point /* p */)
+{
+}
+
+void MctsPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId)
+{
+    recordAttackResultAt(game().grid().cellOf(p), validShot, shotHit, shipDestroyed, shipId);
+}
+
+void MctsPlayer::recordAttackResultAt(int cell, bool validShot, bool shotHit,
+                                      bool shipDestroyed, int shipId)
+{
+    if (!validShot)
+        return;
+    m_shots.insert(cell);
+    if (shotHit)
+        m_hits.insert(cell);
+    if (shipDestroyed)
+        m_sunkAt[shipId] = cell;
+}
+
+// helper function
+// pick a random placement for shipId that covers mustCover (unless it is -1),
+// misses no cell we know is empty and overlaps nothing in occupied.  A sunk ship
+// must lie on hits, and a ship still afloat needs at least one cell not shot yet.
+template <class Shape>
+bool MctsPlayer::choosePlacement(int shipId, int mustCover, const CellSet &occupied, int &chosen,
+                                 Shape shape) const
+{
+    int len = shape.shipLength(shipId);
+    CellSet misses = m_shots.without(m_hits);
+    bool sunk = m_sunkAt[shipId] >= 0;
+    int seen = 0;
+    auto consider = [&](int i) {
+        const CellSet &cells = m_placements[len][i].cells;
+        if (!(cells & occupied).empty() || !(cells & misses).empty())
+            return;
+        if (sunk ? !cells.without(m_hits).empty() : cells.without(m_shots).empty())
+            return;
+        if (randInt(++seen) == 0) // reservoir sampling keeps each candidate equally likely
+            chosen = i;
+    };
+    if (mustCover >= 0)
+        for (int i : m_covering[len][mustCover])
+            consider(i);
+    else
+        for (size_t i = 0; i < m_placements[len].size(); i++)
+            consider(i);
+    return seen > 0;
+}
+
+template <class Shape>
+bool MctsPlayer::sampleFleet(GameState &sample, Shape shape) const
+{
+    const int n = shape.nShips();
+    int chosen[MAXCELLS];
+    for (int attempt = 0; attempt < 20; attempt++)
+    {
+        CellSet occupied;
+        bool ok = true;
+        for (int k = 0; k < n; k++)
+            chosen[k] = -1;
+        // sunk ships first: each lies on hits and covers the cell that sank it
+        for (int k = 0; ok && k < n; k++)
+        {
+            if (m_sunkAt[k] < 0)
+                continue;
+            ok = choosePlacement(k, m_sunkAt[k], occupied, chosen[k], shape);
+            if (ok)
+                occupied = occupied | m_placements[shape.shipLength(k)][chosen[k]].cells;
+        }
+        // then some ship still afloat must cover each remaining hit
+        for (CellSet uncovered = m_hits.without(occupied); ok && !uncovered.empty();
+             uncovered = m_hits.without(occupied))
+        {
+            int h = uncovered.first();
+            int seen = 0, pick = -1, pickPlacement = -1;
+            for (int k = 0; k < n; k++)
+            {
+                int pl;
+                if (chosen[k] < 0 && m_sunkAt[k] < 0 && choosePlacement(k, h, occupied, pl, shape) &&
+                    randInt(++seen) == 0)
+                {
+                    pick = k;
+                    pickPlacement = pl;
+                }
+            }
+            ok = pick >= 0;
+            if (ok)
+            {
+                chosen[pick] = pickPlacement;
+                occupied = occupied | m_placements[shape.shipLength(pick)][pickPlacement].cells;
+            }
+        }
+        // and the rest go anywhere that hasn't been shot at
+        for (int k = 0; ok && k < n; k++)
+        {
+            if (chosen[k] >= 0)
+                continue;
+            ok = choosePlacement(k, -1, occupied | m_shots, chosen[k], shape);
+            if (ok)
+                occupied = occupied | m_placements[shape.shipLength(k)][chosen[k]].cells;
+        }
+        if (!ok)
+            continue;
+
+        sample = GameState(shape.rows(), shape.cols());
+        for (int k = 0; k < n; k++)
+        {
+            const Placement &pl = m_placements[shape.shipLength(k)][chosen[k]];
+            sample.placeShip(1, pl.topOrLeft, k, shape.shipLength(k), pl.dir);
+        }
+        bool hit, destroyed;
+        int id;
+        for (CellSet rest = m_shots; !rest.empty(); rest.erase(rest.first()))
+        {
+            sample.setToMove(0);
+            sample.attack(rest.first(), hit, destroyed, id);
+        }
+        return true;
+    }
+    return false;
+}
+
+// helper function
+// play a sampled game out with a quick policy: shoot next to hits on ships that
+// are still afloat, and otherwise shoot a random cell on a checkerboard.
+// Return the number of shots it took.
+template <class Shape>
+int MctsPlayer::rollout(GameState &state, Shape shape) const
+{
+    const int rows = shape.rows(), cols = shape.cols(), nCells = shape.nCells();
+    int shots = 0;
+    int targets[4 * MAXCELLS];
+    bool hit, destroyed;
+    int id;
+    while (!state.allShipsDestroyed(1))
+    {
+        const SideState &side = state.side(1);
+        int nTargets = 0;
+        for (CellSet open = side.ships & side.shots; !open.empty(); open.erase(open.first()))
+        {
+            int cell = open.first();
+            if (side.hitsLeft[side.shipAt[cell]] == 0)
+                continue;
+            int r = shape.rowOf(cell), c = shape.colOf(cell);
+            if (r > 0 && !side.shots.contains(cell - cols))
+                targets[nTargets++] = cell - cols;
+            if (r + 1 < rows && !side.shots.contains(cell + cols))
+                targets[nTargets++] = cell + cols;
+            if (c > 0 && !side.shots.contains(cell - 1))
+                targets[nTargets++] = cell - 1;
+            if (c + 1 < cols && !side.shots.contains(cell + 1))
+                targets[nTargets++] = cell + 1;
+        }
+        int cell;
+        if (nTargets > 0)
+            cell = targets[randInt(nTargets)];
+        else
+        {
+            int tries = 0;
+            do
+                cell = randInt(nCells);
+            while (side.shots.contains(cell) ||
+                   (++tries < 4 * nCells && (shape.rowOf(cell) + shape.colOf(cell)) % 2 != 0));
+        }
+        state.setToMove(0);
+        state.attack(cell, hit, destroyed, id);
+        shots++;
+    }
+    return shots;
+}
+
+MctsPlayer::Node *MctsPlayer::newNode()
+{
+    int i = m_nodesUsed.fetch_add(1);
+    if (i >= m_nNodes)
+        return nullptr;
+    Node &node = m_nodes[i];
+    node.visits.store(0, memory_order_relaxed);
+    node.value.store(0, memory_order_relaxed);
+    for (int c = 0; c < MAXCELLS; c++)
+        node.child[c].store(nullptr, memory_order_relaxed);
+    return &node;
+}
+
+template <class Shape>
+void MctsPlayer::searchWorker(unsigned seed, chrono::steady_clock::time_point deadline, Shape shape)
+{
+    RandomEngine engine(seed);
+    RandomEngineScope scope(engine);
+    const int nCells = shape.nCells();
+    const double unshot = nCells - m_shots.size();
+    const double explore = 1.5;
+    Node *path[MAXCELLS + 1];
+    bool hit, destroyed;
+    int id;
+
+    while (m_iterationsLeft.fetch_sub(1, memory_order_relaxed) > 0)
+    {
+        if (m_msPerMove > 0 && chrono::steady_clock::now() > deadline)
+            break;
+        GameState state = m_pool[randInt(m_pool.size())];
+        Node *node = &m_nodes[0];
+        node->visits.fetch_add(1, memory_order_relaxed);
+        int depth = 0;
+        path[depth++] = node;
+        int shots = 0;
+        bool expanded = false;
+        // walk down the tree, adding a node when we step off it
+        while (!expanded && !state.allShipsDestroyed(1))
+        {
+            const SideState &side = state.side(1);
+            int parentVisits = node->visits.load(memory_order_relaxed);
+            long long parentValue = node->value.load(memory_order_relaxed);
+            double parentQ = parentVisits > 1 ? parentValue / 1e6 / (parentVisits - 1) : 0.5;
+            double sqrtN = sqrt(double(parentVisits));
+            int best = -1;
+            double bestScore = -1e300;
+            for (int cell = 0; cell < nCells; cell++)
+            {
+                if (side.shots.contains(cell))
+                    continue;
+                Node *child = node->child[cell].load(memory_order_acquire);
+                int n = child ? child->visits.load(memory_order_relaxed) : 0;
+                double q = n > 0 ? child->value.load(memory_order_relaxed) / 1e6 / n : parentQ;
+                double score = q + explore * m_prior[cell] * sqrtN / (1 + n);
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = cell;
+                }
+            }
+            Node *child = node->child[best].load(memory_order_acquire);
+            if (child == nullptr)
+            {
+                Node *fresh = newNode();
+                if (fresh != nullptr)
+                {
+                    Node *expected = nullptr;
+                    if (node->child[best].compare_exchange_strong(expected, fresh))
+                        child = fresh;
+                    else
+                        child = expected; // another thread got there first
+                }
+                expanded = true;
+            }
+            state.setToMove(0);
+            state.attack(best, hit, destroyed, id);
+            shots++;
+            if (child == nullptr) // out of nodes; just play out from here
+                break;
+            child->visits.fetch_add(1, memory_order_relaxed);
+            path[depth++] = child;
+            node = child;
+        }
+        shots += rollout(state, shape);
+        long long score = llround(1e6 * max(0.0, 1.0 - shots / unshot));
+        for (int i = 0; i < depth; i++)
+            path[i]->value.fetch_add(score, memory_order_relaxed);
+    }
+}
+
+Point MctsPlayer::recommendAttack()
+{
+    return game().grid().pointOf(recommendAttackCell());
+}
+
+int MctsPlayer::recommendAttackCell()
+{
+    // until something is sunk, play what the opening book says, if there is one
+    const OpeningBook *book = m_useBook ? OpeningBook::shared(game()) : nullptr;
+    if (book != nullptr && count(m_sunkAt.begin(), m_sunkAt.end(), -1) == int(m_sunkAt.size()))
+    {
+        Cell cell = book->find(ShotState{m_shots, m_hits});
+        if (cell != NOCELL && !m_shots.contains(cell))
+            return cell;
+    }
+    if (m_standard)
+        return chooseCell(StandardGame());
+    return chooseCell(RuntimeGame(game()));
+}
+
+template <class Shape>
+int MctsPlayer::chooseCell(Shape shape)
+{
+    const int nCells = shape.nCells();
+    // sample fleets consistent with what we know, and use how often each cell
+    // is covered as the prior for the tree
+    m_pool.clear();
+    GameState sample;
+    for (int i = 0; i < 256 && sampleFleet(sample, shape); i++)
+        m_pool.push_back(sample);
+    if (m_pool.empty()) // nothing fits what we've seen; take any cell we haven't shot
+    {
+        int cell = randInt(nCells);
+        while (m_shots.contains(cell) && int(m_shots.size()) < nCells)
+            cell = (cell + 1) % nCells;
+        return cell;
+    }
+    fill(m_prior.begin(), m_prior.end(), 0.0);
+    for (const GameState &s : m_pool)
+        for (CellSet rest = s.side(1).ships.without(m_shots); !rest.empty(); rest.erase(rest.first()))
+            m_prior[rest.first()] += 1.0 / m_pool.size();
+    for (int cell = 0; cell < nCells; cell++)
+        m_prior[cell] += 0.01; // every cell stays worth a look
+
+    m_nodesUsed.store(0);
+    newNode(); // the root
+    m_iterationsLeft.store(m_iterations);
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(m_msPerMove);
+    if (m_nThreads == 1)
+        searchWorker(randInt(1 << 30), deadline, shape);
+    else
+    {
+        vector<thread> workers;
+        for (int t = 0; t < m_nThreads; t++)
+            workers.emplace_back(&MctsPlayer::searchWorker<Shape>, this, unsigned(randInt(1 << 30)),
+                                 deadline, shape);
+        for (thread &w : workers)
+            w.join();
+    }
+
+    // play the shot the search looked at most
+    Node &root = m_nodes[0];
+    int best = -1, bestVisits = -1;
+    for (int cell = 0; cell < nCells; cell++)
+    {
+        if (m_shots.contains(cell))
+            continue;
+        Node *child = root.child[cell].load();
+        int n = child ? child->visits.load() : 0;
+        if (n > bestVisits || (n == bestVisits && m_prior[cell] > m_prior[best]))
+        {
+            best = cell;
+            bestVisits = n;
+        }
+    }
+    return best;
+}
+
+Player *createMctsPlayer(string nm, const Game &g, int iterations, int nThreads, int msPerMove,
+                         bool useBook)
+{
+    if (!GameState::fits(g)) // the search works on GameStates
+        return nullptr;
+    if (nThreads < 1)
+        nThreads = max(1u, thread::hardware_concurrency());
+    return new MctsPlayer(nm, g, iterations, nThreads, msPerMove, useBook);
+}
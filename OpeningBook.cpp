@@ -0,0 +1,185 @@
+#include "OpeningBook.h"
+#include "Game.h"
+#include "GameState.h"
+#include "Symmetry.h"
+#include "globals.h"
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A book file is a line naming the game, "opening-book rows cols" and the
+// ship lengths, then a line per entry: the two words of the canonical
+// state's shots and of its hits, in hex, and the cell to shoot on the
+// canonical board.
+
+// The four words of a canonical state, as a key
+typedef array<uint64_t, 4> StateKey;
+
+class OpeningBookImpl
+{
+public:
+    OpeningBookImpl(const Game &g);
+    int size() const { return m_entries.size(); }
+    Cell find(const ShotState &state) const;
+    void add(const ShotState &state, Cell cell);
+    bool load(const string &path);
+    bool save(const string &path) const;
+    bool fits(const Game &g) const { return headerOf(g) == m_header; }
+
+private:
+    static string headerOf(const Game &g);
+    const BoardSymmetry &m_symmetry;
+    string m_header;
+    std::map<StateKey, Cell> m_entries;
+};
+
+// helper function
+// the key of a canonical state
+StateKey keyOf(const ShotState &canonical)
+{
+    return StateKey{canonical.shots.word(0), canonical.shots.word(1), canonical.hits.word(0),
+                    canonical.hits.word(1)};
+}
+
+OpeningBookImpl::OpeningBookImpl(const Game &g)
+    : m_symmetry(BoardSymmetry::shared(g.rows(), g.cols())), m_header(headerOf(g))
+{
+}
+
+string OpeningBookImpl::headerOf(const Game &g)
+{
+    string header = "opening-book " + to_string(g.rows()) + " " + to_string(g.cols());
+    for (int k = 0; k < g.nShips(); k++)
+        header += " " + to_string(g.shipLength(k));
+    return header;
+}
+
+Cell OpeningBookImpl::find(const ShotState &state) const
+{
+    ShotState canonical;
+    int t = m_symmetry.canonicalize(state, canonical);
+    auto entry = m_entries.find(keyOf(canonical));
+    if (entry == m_entries.end())
+        return NOCELL;
+    return m_symmetry.map(entry->second, m_symmetry.inverse(t));
+}
+
+void OpeningBookImpl::add(const ShotState &state, Cell cell)
+{
+    ShotState canonical;
+    int t = m_symmetry.canonicalize(state, canonical);
+    m_entries[keyOf(canonical)] = m_symmetry.map(cell, t);
+}
+
+bool OpeningBookImpl::load(const string &path)
+{
+    m_entries.clear();
+    ifstream in(path);
+    string header;
+    if (!getline(in, header) || header != m_header)
+        return false;
+    StateKey key;
+    Cell cell;
+    while (in >> hex >> key[0] >> key[1] >> key[2] >> key[3] >> dec >> cell)
+    {
+        if (cell < 0 || cell >= m_symmetry.rows() * m_symmetry.cols())
+        {
+            m_entries.clear();
+            return false;
+        }
+        m_entries[key] = cell;
+    }
+    if (!in.eof())
+    {
+        m_entries.clear();
+        return false;
+    }
+    return true;
+}
+
+bool OpeningBookImpl::save(const string &path) const
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    out << m_header << '\n';
+    for (const auto &entry : m_entries)
+        out << hex << entry.first[0] << ' ' << entry.first[1] << ' ' << entry.first[2] << ' '
+            << entry.first[3] << ' ' << dec << entry.second << '\n';
+    return bool(out);
+}
+
+//******************** OpeningBook functions **************************
+
+// These functions simply delegate to OpeningBookImpl's functions.
+
+OpeningBook::OpeningBook(const Game &g)
+{
+    m_impl = new OpeningBookImpl(g);
+}
+
+OpeningBook::~OpeningBook()
+{
+    delete m_impl;
+}
+
+int OpeningBook::size() const
+{
+    return m_impl->size();
+}
+
+Cell OpeningBook::find(const ShotState &state) const
+{
+    return m_impl->find(state);
+}
+
+void OpeningBook::add(const ShotState &state, Cell cell)
+{
+    m_impl->add(state, cell);
+}
+
+bool OpeningBook::load(const string &path)
+{
+    return m_impl->load(path);
+}
+
+bool OpeningBook::save(const string &path) const
+{
+    return m_impl->save(path);
+}
+
+bool OpeningBook::fits(const Game &g) const
+{
+    return m_impl->fits(g);
+}
+
+// The book openShared opened.  It is set before any game starts and never
+// changes while games run, so players read it without a lock.
+static OpeningBook *sharedBook = nullptr;
+
+bool OpeningBook::openShared(const Game &g, const string &path)
+{
+    delete sharedBook;
+    sharedBook = new OpeningBook(g);
+    if (sharedBook->load(path))
+        return true;
+    delete sharedBook;
+    sharedBook = nullptr;
+    return false;
+}
+
+void OpeningBook::closeShared()
+{
+    delete sharedBook;
+    sharedBook = nullptr;
+}
+
+const OpeningBook *OpeningBook::shared(const Game &g)
+{
+    return sharedBook != nullptr && sharedBook->fits(g) ? sharedBook : nullptr;
+}
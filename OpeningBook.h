@@ -0,0 +1,55 @@
+#ifndef OPENINGBOOK_INCLUDED
+#define OPENINGBOOK_INCLUDED
+
+#include "Symmetry.h"
+#include "globals.h"
+#include <string>
+
+class Game;
+class OpeningBookImpl;
+
+  // The file the buildbook command writes unless told otherwise
+const char* const STANDARD_BOOK_FILE = "opening.book";
+
+  // An OpeningBook holds the shot to play in shot states of one board and
+  // fleet, for the opening before any ship is sunk.  It keeps only
+  // canonical states (see BoardSymmetry), so a state and its mirror images
+  // and turns share one entry, and the shot is turned back to fit the state
+  // it is looked up for.
+class OpeningBook
+{
+  public:
+      // An empty book for g's board and fleet, which must fit a GameState
+    OpeningBook(const Game& g);
+    ~OpeningBook();
+      // The number of entries, each standing for up to 8 states
+    int size() const;
+      // Return the shot for state, or NOCELL if the book doesn't know it
+    Cell find(const ShotState& state) const;
+      // Record cell as the shot to play in state
+    void add(const ShotState& state, Cell cell);
+      // Replace the book with the one in path; return false, leaving the
+      // book empty, if it can't be read or was written for another game
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+      // Return true if the book is for g's board and fleet
+    bool fits(const Game& g) const;
+      // Make the book in path, written for g's board and fleet, the one mcts
+      // players play from.  There is none unless this is called, and it must
+      // be called before any game starts.  Return false, leaving none, if
+      // path holds no book for g.
+    static bool openShared(const Game& g, const std::string& path);
+      // Go back to having no shared book; like openShared, only before any
+      // game starts
+    static void closeShared();
+      // Return the book openShared opened if it fits g, or nullptr
+    static const OpeningBook* shared(const Game& g);
+      // We prevent an OpeningBook object from being copied or assigned
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+  private:
+    OpeningBookImpl* m_impl;
+};
+
+#endif // OPENINGBOOK_INCLUDED
@@ -1,16 +1,22 @@
 #include "Player.h"
+#include "BuiltinPlayers.h"
 #include "Board.h"
+#include "CellGrid.h"
+#include "FixedGame.h"
+#include "FleetSampler.h"
 #include "Game.h"
+#include "LayoutCorpus.h"
 #include "globals.h"
 #include <iostream>
 #include <string>
 #include <algorithm>
+#include <cstdlib>
 
 using namespace std;
 
 // helper function
 // find the position of the same Point in a vector
-int find(vector<Point> cell, Point p)
+int find(const vector<Point> &cell, Point p)
 {
     for (size_t i = 0; i < cell.size(); i++)
     {
@@ -21,25 +27,46 @@ int find(vector<Point> cell, Point p)
 }
 
 //*********************************************************************
-//  AwfulPlayer
+//  Player
 //*********************************************************************
 
-class AwfulPlayer : public Player
+int Player::recommendAttackCell()
 {
-public:
-    AwfulPlayer(string nm, const Game &g);
-    virtual bool placeShips(Board &b);
-    virtual Point recommendAttack();
-    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
-                                    bool shipDestroyed, int shipId);
-    virtual void recordAttackByOpponent(Point p);
+    return game().grid().cellOf(recommendAttack());
+}
 
-private:
-    Point m_lastCellAttacked;
-};
+void Player::recordAttackResultAt(int cell, bool validShot, bool shotHit,
+                                  bool shipDestroyed, int shipId)
+{
+    const CellGrid &cells = game().grid();
+    recordAttackResult(cells.isValid(cell) ? cells.pointOf(cell) : Point(-1, -1),
+                       validShot, shotHit, shipDestroyed, shipId);
+}
+
+void Player::recordAttackByOpponentAt(int cell)
+{
+    const CellGrid &cells = game().grid();
+    recordAttackByOpponent(cells.isValid(cell) ? cells.pointOf(cell) : Point(-1, -1));
+}
+
+void Player::recommendAttacks(int /* k */, vector<Point> &shots)
+{
+    shots.assign(1, recommendAttack());
+}
+
+void Player::recordAttackResults(const vector<Point> &shots, const vector<ShotResult> &results)
+{
+    for (size_t i = 0; i < shots.size(); i++)
+        recordAttackResult(shots[i], results[i].valid, results[i].hit, results[i].destroyed,
+                           results[i].shipId);
+}
+
+//*********************************************************************
+//  AwfulPlayer
+//*********************************************************************
 
 AwfulPlayer::AwfulPlayer(string nm, const Game &g)
-    : Player(nm, g), m_lastCellAttacked(0, 0)
+    : Player(nm, g), m_cells(g.grid()), m_lastCellAttacked(0)
 {
 }
 
@@ -54,29 +81,15 @@ bool AwfulPlayer::placeShips(Board &b)
 
 Point AwfulPlayer::recommendAttack()
 {
-    if (m_lastCellAttacked.c > 0)
-        m_lastCellAttacked.c--;
-    else
-    {
-        m_lastCellAttacked.c = game().cols() - 1;
-        if (m_lastCellAttacked.r > 0)
-            m_lastCellAttacked.r--;
-        else
-            m_lastCellAttacked.r = game().rows() - 1;
-    }
-    return m_lastCellAttacked;
-}
-
-void AwfulPlayer::recordAttackResult(Point /* p */, bool /* validShot */,
-                                     bool /* shotHit */, bool /* shipDestroyed */,
-                                     int /* shipId */)
-{
-    // AwfulPlayer completely ignores the result of any attack
+    return m_cells.pointOf(recommendAttackCell());
 }
 
-void AwfulPlayer::recordAttackByOpponent(Point /* p */)
+void AwfulPlayer::recommendAttacks(int k, vector<Point> &shots)
 {
-    // AwfulPlayer completely ignores what the opponent does
+    // it ignores results anyway, so it fires its whole salvo at once
+    shots.clear();
+    for (int i = 0; i < k && i < m_cells.nCells(); i++)
+        shots.push_back(m_cells.pointOf(recommendAttackCell()));
 }
 
 //*********************************************************************
@@ -212,38 +225,26 @@ void HumanPlayer::recordAttackByOpponent(Point /* p */)
 //  MediocrePlayer
 //*********************************************************************
 
-class MediocrePlayer : public Player
-{
-public:
-    MediocrePlayer(string nm, const Game &g);
-    virtual bool placeShips(Board &b);
-    virtual Point recommendAttack();
-    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
-                                    bool shipDestroyed, int shipId);
-    virtual void recordAttackByOpponent(Point p);
-
-private:
-    bool place(int k, int total, Board &b);
-    vector<Point> CellNotDiscovered;
-    vector<Point> cellToHit;
-    Point m_shipCell;
-    bool m_shotHit;
-    bool m_shipDestroyed;
-    bool m_state;
-};
-
-MediocrePlayer::MediocrePlayer(string nm, const Game &g)
-    : Player(nm, g), m_state(true)
+MediocrePlayer::MediocrePlayer(string nm, const Game &g, int placementTries)
+    : Player(nm, g), m_placementTries(placementTries), m_state(true)
 {
+    CellNotDiscovered.reserve(g.rows() * g.cols());
     for (int r = 0; r < g.rows(); r++) // push all points into undiscovered
         for (int c = 0; c < g.cols(); c++)
             CellNotDiscovered.push_back(Point(r, c));
+
+    // every hit that starts a hunt pushes 16 cells, and there is at most one
+    // hunt per ship cell, so reserve that up front to keep turns allocation free
+    int totalLength = 0;
+    for (int i = 0; i < g.nShips(); i++)
+        totalLength += g.shipLength(i);
+    cellToHit.reserve(16 * totalLength);
 }
 
 bool MediocrePlayer::placeShips(Board &b)
 {
     bool res;
-    for (int count = 0; count < 50; count++) // try place ship 50 times
+    for (int count = 0; count < m_placementTries; count++) // try placing the ships this many times
     {
         b.block();
         res = place(0, game().nShips(), b);
@@ -297,10 +298,6 @@ bool MediocrePlayer::place(int k, int total, Board &b)
     return false;
 }
 
-void MediocrePlayer::recordAttackByOpponent(Point /* p */)
-{
-}
-
 void MediocrePlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
                                         bool shipDestroyed, int shipId)
 {
@@ -360,40 +357,28 @@ Point MediocrePlayer::recommendAttack()
 //  GoodPlayer
 //*********************************************************************
 
-class GoodPlayer : public Player
-{
-public:
-    GoodPlayer(string nm, const Game &g);
-    virtual bool placeShips(Board &b);
-    virtual Point recommendAttack();
-    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
-                                    bool shipDestroyed, int shipId);
-    virtual void recordAttackByOpponent(Point p);
-
-private:
-    bool place(int k, int total, Board &b);
-    bool randomPlace(int k, int total, Board &b, vector<Point> &placedCell);
-    Point m_shipCell;
-    bool m_shotHit;
-    bool m_shipDestroyed;
-    bool m_state;
-    Point toCheck;
-    int shortestShip;
-    vector<int> shipIdDestroyed;
-    vector<Point> CellNotDiscovered;
-    vector<Point> ship;
-};
-
-GoodPlayer::GoodPlayer(string nm, const Game &g)
-    : Player(nm, g), m_state(true), toCheck(0, 0), shortestShip(MAXROWS)
+GoodPlayer::GoodPlayer(string nm, const Game &g, int probeRadius, int overflowGuard)
+    : Player(nm, g), m_probeRadius(probeRadius), m_overflowGuard(overflowGuard), m_state(true),
+      toCheck(0, 0), shortestShip(MAXROWS), m_sampler(FleetSampler::shared(g)),
+      m_standard(StandardGame::matches(g))
 {
+    int totalLength = 0;
     for (int i = 0; i < g.nShips(); i++) // find shortest ship on board
+    {
+        totalLength += g.shipLength(i);
         if (shortestShip > g.shipLength(i))
             shortestShip = g.shipLength(i);
+    }
 
+    CellNotDiscovered.reserve(g.rows() * g.cols());
     for (int r = 0; r < g.rows(); r++) // input all cell not attacked
         for (int c = 0; c < g.cols(); c++)
             CellNotDiscovered.push_back(Point(r, c));
+
+    // a hit pushes at most 4 cells when it starts a hunt and 1 cell otherwise,
+    // so reserve the worst case here to keep turns allocation free
+    ship.reserve(5 * totalLength);
+    shipIdDestroyed.reserve(g.nShips());
 }
 
 bool GoodPlayer::place(int k, int total, Board &b)
@@ -439,103 +424,38 @@ bool GoodPlayer::place(int k, int total, Board &b)
     return false;
 }
 
-bool GoodPlayer::randomPlace(int k, int total, Board &b, vector<Point> &placedCell)
-{
-    int count = 0;
-    while (count < 50)
-    {
-        count++;
-        int r = randInt(game().rows());
-        int c = randInt(game().cols());
-        Direction dir;
-        bool valid = true;
-        const int length = game().shipLength(k);
-        if (randInt(2)) // randomly select direction
-        {
-            dir = HORIZONTAL;
-            if (c + length > game().cols()) // do it again if out of bound
-                continue;
-            for (int i = c; i < c + length; i++)
-            {
-                for (Point x : placedCell)
-                {
-                    int d = (x.r - r) * (x.r - r) + (x.c - i) * (x.c - i); // if the ship is in contact with other ship
-                    if (d < 1)                                             // saved by placed cell do it again
-                        valid = false;
-                    break;
-                }
-                if (!valid)
-                    break;
-            }
-            if (!valid)
-                continue;
-            for (int i = c; i < c + length; i++) // save it to placedCell
-                placedCell.push_back(Point(r, i));
-        }
-        else
-        {
-            dir = VERTICAL;
-            if (r + length > game().rows())
-                continue;
-            for (int i = r; i < r + length; i++)
-            {
-                for (Point x : placedCell)
-                {
-                    int d = (x.r - i) * (x.r - i) + (x.c - c) * (x.c - c);
-                    if (d < 1)
-                        valid = false;
-                    break;
-                }
-                if (!valid)
-                    break;
-            }
-            if (!valid)
-                continue;
-            for (int i = r; i < r + length; i++)
-                placedCell.push_back(Point(i, c));
-        }
-
-        if (b.placeShip(Point(r, c), k, dir)) // if place ship success proceed to next ship
-        {
-            if (k + 1 < total)
-            {
-                if (place(k + 1, total, b))
-                    return true;
-                b.unplaceShip(Point(r, c), k, dir); // if placement not working unplace it
-                int cellCount = 0;
-                for (int i = 0; i < k; i++)
-                    cellCount += game().shipLength(i);
-
-                for (int i = 0; i < length; i++)
-                    placedCell.erase(placedCell.begin() + cellCount);
-            }
-            else
-                return true;
-        }
-        else
-        {
-            for (int i = 0; i < length; i++)
-                placedCell.pop_back();
-        }
-    }
-    return false;
-}
-
 bool GoodPlayer::placeShips(Board &b)
 {
-    vector<Point> placedCell;
-    if (randomPlace(0, game().nShips(), b, placedCell))
+    // every layout is equally likely, so where we put one ship says nothing about the others;
+    // a corpus of layouts written ahead of time saves drawing one now
+    const LayoutCorpus *corpus = LayoutCorpus::shared(game());
+    if (corpus != nullptr && corpus->placeShips(b))
+        return true;
+    if (m_sampler.placeShips(b))
         return true;
     b.clear();
     return place(0, game().nShips(), b);
 }
 
-void GoodPlayer::recordAttackByOpponent(Point /* p */)
+void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId)
 {
+    if (m_standard)
+        recordAttackResultOn(StandardGame(), p, validShot, shotHit, shipDestroyed, shipId);
+    else
+        recordAttackResultOn(RuntimeGame(game()), p, validShot, shotHit, shipDestroyed, shipId);
 }
 
-void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
-                                    bool shipDestroyed, int shipId)
+Point GoodPlayer::recommendAttack()
+{
+    if (m_standard)
+        return recommendAttackOn(StandardGame());
+    return recommendAttackOn(RuntimeGame(game()));
+}
+
+template <class Shape>
+void GoodPlayer::recordAttackResultOn(const Shape &shape, Point p, bool /* validShot */, bool shotHit,
+                                      bool shipDestroyed, int shipId)
 {
     int x = find(CellNotDiscovered, p);
     CellNotDiscovered.erase(CellNotDiscovered.begin() + x);
@@ -554,7 +474,7 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
 
         // following function to find a cell all four direction and put to the back of ship
         int c = p.c + 1;
-        while (c < game().cols() && c - p.c < 5)
+        while (c < shape.cols() && c - p.c < m_probeRadius)
         {
             if (CellNotDiscovered.begin() + find(CellNotDiscovered, Point(p.r, c)) ==
                 CellNotDiscovered.end()) // if cell already attack proceed to next one
@@ -568,7 +488,7 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
             }
         }
         c = p.c - 1;
-        while (c >= 0 && p.c - c < 5)
+        while (c >= 0 && p.c - c < m_probeRadius)
         {
             if (CellNotDiscovered.begin() + find(CellNotDiscovered, Point(p.r, c)) ==
                 CellNotDiscovered.end())
@@ -582,7 +502,7 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
             }
         }
         int r = p.r + 1;
-        while (r < game().rows() && r - p.r < 5)
+        while (r < shape.rows() && r - p.r < m_probeRadius)
         {
             if (CellNotDiscovered.begin() + find(CellNotDiscovered, Point(r, p.c)) ==
                 CellNotDiscovered.end())
@@ -596,7 +516,7 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
             }
         }
         r = p.r - 1;
-        while (r >= 0 && p.r - r < 5)
+        while (r >= 0 && p.r - r < m_probeRadius)
         {
             if (CellNotDiscovered.begin() + find(CellNotDiscovered, Point(r, p.c)) ==
                 CellNotDiscovered.end())
@@ -617,10 +537,10 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
         {
             shipIdDestroyed.push_back(shipId);
             m_state = true;
-            if (game().shipLength(shipId) == shortestShip) // when ship destroyed, check if the shortest ship still exist
+            if (shape.shipLength(shipId) == shortestShip) // when ship destroyed, check if the shortest ship still exist
             {
                 shortestShip = MAXROWS;
-                for (int i = 0; i < game().nShips(); i++) // search for shortest ship
+                for (int i = 0; i < shape.nShips(); i++) // search for shortest ship
                 {
                     bool jump = false;
                     for (int x : shipIdDestroyed)
@@ -633,8 +553,8 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
                     }
                     if (jump)
                         continue;
-                    if (shortestShip > game().shipLength(i))
-                        shortestShip = game().shipLength(i);
+                    if (shortestShip > shape.shipLength(i))
+                        shortestShip = shape.shipLength(i);
                 }
             }
         }
@@ -644,12 +564,12 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
             {
                 if (m_shipCell.c < p.c)
                 {
-                    if (p.c - m_shipCell.c + 1 < 5 && p.c + 1 < game().cols()) // find next cell available
+                    if (p.c - m_shipCell.c + 1 < m_probeRadius && p.c + 1 < shape.cols()) // find next cell available
                         ship.push_back(Point(p.r, p.c + 1));
                 }
                 else
                 {
-                    if (m_shipCell.c - p.c + 1 < 5 && p.c - 1 >= 0)
+                    if (m_shipCell.c - p.c + 1 < m_probeRadius && p.c - 1 >= 0)
                         ship.push_back(Point(p.r, p.c - 1));
                 }
             }
@@ -657,12 +577,12 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
             {
                 if (m_shipCell.r < p.r)
                 {
-                    if (p.r - m_shipCell.r + 1 < 5 && p.r + 1 < game().rows())
+                    if (p.r - m_shipCell.r + 1 < m_probeRadius && p.r + 1 < shape.rows())
                         ship.push_back(Point(p.r + 1, p.c));
                 }
                 else
                 {
-                    if (m_shipCell.r - p.r + 1 < 5 && p.r - 1 >= 0)
+                    if (m_shipCell.r - p.r + 1 < m_probeRadius && p.r - 1 >= 0)
                         ship.push_back(Point(p.r - 1, p.c));
                 }
             }
@@ -673,17 +593,18 @@ void GoodPlayer::recordAttackResult(Point p, bool validShot, bool shotHit,
     }
 }
 
-Point GoodPlayer::recommendAttack()
+template <class Shape>
+Point GoodPlayer::recommendAttackOn(const Shape &shape)
 {
     if (m_state)
     {
         while (CellNotDiscovered.begin() + find(CellNotDiscovered, toCheck) == CellNotDiscovered.end()) // if cell already attacked, find next
         {
             toCheck.c += shortestShip;
-            if (toCheck.c >= game().cols()) // if exceed column, row++
+            if (toCheck.c >= shape.cols()) // if exceed column, row++
             {
                 toCheck.r++;
-                if (toCheck.r >= game().rows()) // if row exceed limit find the first not attacked cell
+                if (toCheck.r >= shape.rows()) // if row exceed limit find the first not attacked cell
                     return CellNotDiscovered.front();
                 toCheck.c = 0;
                 while ((toCheck.c + toCheck.r) % shortestShip != 0) // find the column "shortestShip" length behind prev step
@@ -694,7 +615,7 @@ Point GoodPlayer::recommendAttack()
     }
     else
     {
-        if (ship.size() > 200) // if run into infinite loop, since repitition is not checked when push into ship
+        if (int(ship.size()) > m_overflowGuard) // if run into infinite loop, since repitition is not checked when push into ship
         {
             m_state = true;
             return CellNotDiscovered.front();
@@ -717,14 +638,81 @@ Point GoodPlayer::recommendAttack()
 //  createPlayer
 //*********************************************************************
 
-Player *createPlayer(string type, string nm, const Game &g)
+// every type createPlayer knows about; add new players here and to the switch
+static const string playerTypes[] = {
+    "human", "awful", "mediocre", "good", "mcts"};
+
+vector<PlayerParam> playerParams(const string &type)
 {
-    static string types[] = {
-        "human", "awful", "mediocre", "good"};
+    if (type == "mediocre")
+        return {{"tries", 50, 1, 200}};
+    if (type == "good")
+        return {{"radius", 5, 2, 10}, {"guard", 200, 10, 1000}};
+    if (type == "mcts") // one thread and no clock, so its games can be replayed from their seeds
+        return {{"iterations", 2000, 100, 100000}, {"threads", 1, 0, 256}, {"ms", 0, 0, 60000}};
+    return {};
+}
+
+string playerTypeWith(const string &type, const vector<int> &values)
+{
+    vector<PlayerParam> params = playerParams(type);
+    string result = type;
+    for (size_t i = 0; i < params.size() && i < values.size(); i++)
+        result += (i == 0 ? ":" : ",") + params[i].name + "=" + to_string(values[i]);
+    return result;
+}
+
+// helper function
+// set values to the settings in spec, a list like "radius=4,guard=100", of
+// params, starting from their defaults; return false if spec is malformed,
+// names a parameter not in params, or sets one out of its range
+bool parseParams(const string &spec, const vector<PlayerParam> &params, vector<int> &values)
+{
+    values.clear();
+    for (const PlayerParam &param : params)
+        values.push_back(param.value);
+    size_t start = 0;
+    while (start < spec.size())
+    {
+        size_t end = spec.find(',', start);
+        if (end == string::npos)
+            end = spec.size();
+        size_t eq = spec.find('=', start);
+        if (eq == string::npos || eq >= end || eq + 1 == end)
+            return false;
+        string name = spec.substr(start, eq - start);
+        size_t k = 0;
+        while (k < params.size() && params[k].name != name)
+            k++;
+        if (k == params.size())
+            return false;
+        string digits = spec.substr(eq + 1, end - eq - 1);
+        if (digits.size() > 9 || digits.find_first_not_of("0123456789") != string::npos)
+            return false;
+        int value = atoi(digits.c_str());
+        if (value < params[k].low || value > params[k].high)
+            return false;
+        values[k] = value;
+        start = end + 1;
+    }
+    return true;
+}
 
+Player *createPlayer(string type, string nm, const Game &g)
+{
+    if (type.compare(0, 9, "external:") == 0) // "external:<command>" runs a bot in another process
+        return createExternalPlayer(type.substr(9), nm, g);
+    vector<int> values;
+    size_t colon = type.find(':');
+    if (!parseParams(colon == string::npos ? "" : type.substr(colon + 1),
+                     playerParams(type.substr(0, colon)), values))
+        return nullptr;
+    type = type.substr(0, colon);
+    if (colon != string::npos && values.empty()) // settings for a type that takes none
+        return nullptr;
     int pos;
-    for (pos = 0; pos != sizeof(types) / sizeof(types[0]) &&
-                  type != types[pos];
+    for (pos = 0; pos != sizeof(playerTypes) / sizeof(playerTypes[0]) &&
+                  type != playerTypes[pos];
          pos++)
         ;
     switch (pos)
@@ -734,10 +722,50 @@ Player *createPlayer(string type, string nm, const Game &g)
     case 1:
         return new AwfulPlayer(nm, g);
     case 2:
-        return new MediocrePlayer(nm, g);
+        return new MediocrePlayer(nm, g, values[0]);
     case 3:
-        return new GoodPlayer(nm, g);
+        return new GoodPlayer(nm, g, values[0], values[1]);
+    case 4:
+        return createMctsPlayer(nm, g, values[0], values[1], values[2]);
     default:
         return nullptr;
     }
 }
+
+vector<string> computerPlayerTypes()
+{
+    vector<string> types;
+    for (const string &type : playerTypes)
+        if (type != "human") // humans can't take part in unattended matches
+            types.push_back(type);
+    return types;
+}
+
+vector<string> defaultPlayerTypes()
+{
+    vector<string> types = computerPlayerTypes();
+    types.erase(remove(types.begin(), types.end(), "mcts"), types.end());
+    return types;
+}
+
+int shotsToSink(Player *attacker, const Game &g, const vector<ShipPlacement> &layout)
+{
+    if (int(layout.size()) != g.nShips())
+        return -1;
+    Board b(g);
+    for (size_t k = 0; k < layout.size(); k++)
+        if (!b.placeShip(layout[k].topOrLeft, k, layout[k].dir))
+            return -1;
+    const int limit = g.rows() * g.cols() * 10;
+    int shots = 0;
+    while (shots < limit && !b.allShipsDestroyed())
+    {
+        Point target = attacker->recommendAttack();
+        bool shotHit = false, shipDestroyed = false; // a wasted shot sets neither
+        int shipId = -1;
+        bool validShot = b.attack(target, shotHit, shipDestroyed, shipId);
+        attacker->recordAttackResult(target, validShot, shotHit, shipDestroyed, shipId);
+        shots++;
+    }
+    return shots;
+}
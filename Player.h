@@ -2,10 +2,13 @@
 #define PLAYER_INCLUDED
 
 #include <string>
+#include <vector>
 
 class Point;
 class Board;
 class Game;
+struct ShotResult;
+struct ShipPlacement;
 
 class Player
 {
@@ -16,15 +19,36 @@ class Player
 
     virtual ~Player() {}
 
-    std::string name() const { return m_name; }
+    const std::string& name() const { return m_name; }
     const Game& game() const { return m_game; }
 
     virtual bool isHuman() const { return false; }
+      // A player that can no longer play, such as a bot that stopped
+      // answering, returns true; it loses the game at the end of its turn
+    virtual bool hasForfeited() const { return false; }
     virtual bool placeShips(Board& b) = 0;
     virtual Point recommendAttack() = 0;
     virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
                                         bool shipDestroyed, int shipId) = 0;
     virtual void recordAttackByOpponent(Point p) = 0;
+      // A player that returns true from attacksByCell is asked for its shots
+      // and told about them through the functions below instead, with cells
+      // numbered as in game().grid(), so neither side converts to Points.  By
+      // default they convert to and from the Point functions above.
+    virtual bool attacksByCell() const { return false; }
+    virtual int recommendAttackCell();
+    virtual void recordAttackResultAt(int cell, bool validShot, bool shotHit,
+                                      bool shipDestroyed, int shipId);
+    virtual void recordAttackByOpponentAt(int cell);
+      // In a salvo game (see Game::setShotsPerTurn) a player fires up to k
+      // shots a turn.  recommendAttacks replaces shots with the ones to fire
+      // together, and recordAttackResults then reports them all at once; the
+      // opponent still hears of each through recordAttackByOpponent.  By
+      // default a player fires just recommendAttack(), is told how it went,
+      // and is asked again for the rest of its shots.
+    virtual void recommendAttacks(int k, std::vector<Point>& shots);
+    virtual void recordAttackResults(const std::vector<Point>& shots,
+                                     const std::vector<ShotResult>& results);
       // We prevent any kind of Player object from being copied or assigned
     Player(const Player&) = delete;
     Player& operator=(const Player&) = delete;
@@ -34,6 +58,49 @@ class Player
     const Game& m_game;
 };
 
+  // type is one of computerPlayerTypes(), "human", or "external:<command>".
+  // A type with parameters (see playerParams) may be followed by settings
+  // for some of them, as in "good:radius=4,guard=100".
 Player* createPlayer(std::string type, std::string nm, const Game& g);
 
+  // Attack layout, a fleet of g's ships, with attacker alone until every
+  // ship is sunk or it has fired ten shots per cell; return the shots it
+  // fired, or -1 if layout doesn't fit g
+int shotsToSink(Player* attacker, const Game& g, const std::vector<ShipPlacement>& layout);
+
+  // A number a computer player's play depends on
+struct PlayerParam
+{
+    std::string name;
+    int value; // what createPlayer uses unless the type sets it
+    int low;   // the range createPlayer accepts and a Tuner searches
+    int high;
+};
+
+  // Return the parameters a player type can be given, in the order
+  // playerTypeWith writes them
+std::vector<PlayerParam> playerParams(const std::string& type);
+
+  // Return the createPlayer type for type's players with every parameter
+  // set to the corresponding entry of values
+std::string playerTypeWith(const std::string& type, const std::vector<int>& values);
+
+  // A Monte Carlo tree search player that runs up to iterations playouts per
+  // move on nThreads threads (0 means one per core), stopping early after
+  // msPerMove milliseconds if that isn't 0, and playing from the opening
+  // book unless useBook is false; see MctsPlayer.cpp
+Player* createMctsPlayer(std::string nm, const Game& g, int iterations,
+                         int nThreads, int msPerMove, bool useBook = true);
+
+  // Run a bot in another process, either by starting command or, for
+  // "unix:<path>", by connecting to a socket; see ExternalPlayer.cpp
+Player* createExternalPlayer(const std::string& command, std::string nm, const Game& g);
+
+  // Return every createPlayer type that can play without a human at the keyboard
+std::vector<std::string> computerPlayerTypes();
+
+  // Return the types unattended matches play when none are named: every
+  // computer player but mcts, whose games take about a second each
+std::vector<std::string> defaultPlayerTypes();
+
 #endif // PLAYER_INCLUDED
@@ -0,0 +1,131 @@
+#include "Rating.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// natural-log strength to Elo points
+const double ELO_PER_UNIT = 400.0 / log(10.0);
+
+vector<Rating> computeRatings(const vector<string> &types, const vector<PairResult> &results)
+{
+    const int n = types.size();
+    vector<vector<double>> played(n, vector<double>(n, 0)); // games between i and j that had a winner
+    vector<double> wins(n, 0);
+    vector<Rating> ratings(n);
+    for (int i = 0; i < n; i++)
+        ratings[i] = Rating{types[i], 0, 0, 0, 0, 0};
+
+    for (const PairResult &res : results)
+    {
+        int a = find(types.begin(), types.end(), res.first) - types.begin();
+        int b = find(types.begin(), types.end(), res.second) - types.begin();
+        if (a == n || b == n || a == b)
+            continue;
+        played[a][b] += res.firstWins + res.secondWins;
+        played[b][a] += res.firstWins + res.secondWins;
+        wins[a] += res.firstWins;
+        wins[b] += res.secondWins;
+        ratings[a].games += res.games;
+        ratings[b].games += res.games;
+        ratings[a].wins += res.firstWins;
+        ratings[b].wins += res.secondWins;
+    }
+
+    // Fit gamma with Hunter's MM iteration.  Every player also gets one
+    // virtual game split evenly against a gamma 1 opponent, so an unbeaten or
+    // winless player still gets a finite rating.
+    vector<double> gamma(n, 1.0);
+    for (int iter = 0; iter < 10000; iter++)
+    {
+        double change = 0;
+        for (int i = 0; i < n; i++)
+        {
+            double denom = 1.0 / (gamma[i] + 1.0);
+            for (int j = 0; j < n; j++)
+                if (j != i && played[i][j] > 0)
+                    denom += played[i][j] / (gamma[i] + gamma[j]);
+            double updated = (wins[i] + 0.5) / denom;
+            change = max(change, fabs(log(updated / gamma[i])));
+            gamma[i] = updated;
+        }
+        if (change < 1e-10)
+            break;
+    }
+
+    double mean = 0;
+    for (int i = 0; i < n; i++)
+        mean += log(gamma[i]);
+    mean /= max(n, 1);
+
+    for (int i = 0; i < n; i++)
+    {
+        // the variance of each strength comes from its own Fisher information,
+        // holding the other players fixed
+        double info = gamma[i] / ((gamma[i] + 1.0) * (gamma[i] + 1.0));
+        for (int j = 0; j < n; j++)
+        {
+            if (j == i || played[i][j] == 0)
+                continue;
+            double p = gamma[i] / (gamma[i] + gamma[j]);
+            info += played[i][j] * p * (1 - p);
+        }
+        double err = 1.96 * ELO_PER_UNIT / sqrt(info);
+        ratings[i].elo = ELO_PER_UNIT * (log(gamma[i]) - mean);
+        ratings[i].ciLow = ratings[i].elo - err;
+        ratings[i].ciHigh = ratings[i].elo + err;
+    }
+
+    sort(ratings.begin(), ratings.end(),
+         [](const Rating &a, const Rating &b) { return a.elo > b.elo; });
+    return ratings;
+}
+
+double eloToScore(double elo)
+{
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+double sprtLlr(int wins, int losses, double elo0, double elo1)
+{
+    double p0 = eloToScore(elo0);
+    double p1 = eloToScore(elo1);
+    return wins * log(p1 / p0) + losses * log((1 - p1) / (1 - p0));
+}
+
+double scoreToElo(double p)
+{
+    return -400.0 * log10(1.0 / p - 1.0);
+}
+
+void estimateElo(int wins, int losses, double &elo, double &low, double &high)
+{
+    // half a win and half a loss keep the estimate finite after a whitewash,
+    // and the Wilson interval keeps both ends strictly between 0 and 1
+    const double z = 1.96;
+    double n = wins + losses + 1.0;
+    double p = (wins + 0.5) / n;
+    double centre = (p + z * z / (2 * n)) / (1 + z * z / n);
+    double err = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+    elo = scoreToElo(p);
+    low = scoreToElo(centre - err);
+    high = scoreToElo(centre + err);
+}
+
+bool writeRatingsCsv(const string &path, const vector<Rating> &ratings)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    out << "rank,type,elo,ci_low,ci_high,games,wins" << '\n';
+    for (size_t i = 0; i < ratings.size(); i++)
+    {
+        const Rating &r = ratings[i];
+        out << i + 1 << ',' << r.type << ',' << r.elo << ',' << r.ciLow << ','
+            << r.ciHigh << ',' << r.games << ',' << r.wins << '\n';
+    }
+    return bool(out);
+}
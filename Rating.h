@@ -0,0 +1,33 @@
+#ifndef RATING_INCLUDED
+#define RATING_INCLUDED
+
+#include "Tournament.h"
+#include <string>
+#include <vector>
+
+  // A Bradley-Terry strength on the Elo scale, with a 95% confidence interval
+struct Rating
+{
+    std::string type;
+    double elo;
+    double ciLow;
+    double ciHigh;
+    int games;
+    int wins;
+};
+
+  // Fit ratings to the results of a round robin; the ratings average 0 and
+  // are returned strongest first
+std::vector<Rating> computeRatings(const std::vector<std::string>& types,
+                                   const std::vector<PairResult>& results);
+  // Expected score of a player elo points stronger than its opponent
+double eloToScore(double elo);
+  // Elo difference that gives an expected score of p, for 0 < p < 1
+double scoreToElo(double p);
+  // Log-likelihood ratio of elo1 against elo0 given a player's wins and losses
+double sprtLlr(int wins, int losses, double elo0, double elo1);
+  // Estimate a strength difference from wins and losses with a 95% interval
+void estimateElo(int wins, int losses, double& elo, double& low, double& high);
+bool writeRatingsCsv(const std::string& path, const std::vector<Rating>& ratings);
+
+#endif // RATING_INCLUDED
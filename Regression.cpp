@@ -0,0 +1,204 @@
+#include "Regression.h"
+#include "Game.h"
+#include "Player.h"
+#include "globals.h"
+#include <chrono>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A TimedPlayer plays for another player on its own random engine, timing
+// every call and folding every shot it is told about into a fingerprint.
+class TimedPlayer : public Player
+{
+public:
+    TimedPlayer(Player *p, const Game &g, RandomEngine &engine, PhaseTimes &times,
+                unsigned long long &fingerprint)
+        : Player(p->name(), g), m_player(p), m_engine(engine), m_times(times),
+          m_fingerprint(fingerprint)
+    {
+    }
+    virtual bool placeShips(Board &b)
+    {
+        RandomEngineScope scope(m_engine);
+        auto begin = chrono::steady_clock::now();
+        bool placed = m_player->placeShips(b);
+        m_times.placing += elapsedSince(begin);
+        return placed;
+    }
+    virtual Point recommendAttack()
+    {
+        RandomEngineScope scope(m_engine);
+        auto begin = chrono::steady_clock::now();
+        Point p = m_player->recommendAttack();
+        m_times.attacking += elapsedSince(begin);
+        m_times.attacks++;
+        return p;
+    }
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId)
+    {
+        mix(p.r);
+        mix(p.c);
+        mix(validShot | shotHit << 1 | shipDestroyed << 2);
+        mix(shipDestroyed ? shipId : -1);
+        RandomEngineScope scope(m_engine);
+        auto begin = chrono::steady_clock::now();
+        m_player->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+        m_times.recording += elapsedSince(begin);
+        m_times.records++;
+    }
+    virtual void recordAttackByOpponent(Point p)
+    {
+        RandomEngineScope scope(m_engine);
+        auto begin = chrono::steady_clock::now();
+        m_player->recordAttackByOpponent(p);
+        m_times.recording += elapsedSince(begin);
+        m_times.records++;
+    }
+    virtual bool hasForfeited() const { return m_player->hasForfeited(); }
+    void mix(long value)
+    {
+        // 64-bit FNV-1a over the value's bytes
+        for (int i = 0; i < 4; i++)
+        {
+            m_fingerprint ^= (value >> (8 * i)) & 0xff;
+            m_fingerprint *= 1099511628211ULL;
+        }
+    }
+
+private:
+    static double elapsedSince(chrono::steady_clock::time_point begin)
+    {
+        return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    }
+    Player *m_player;
+    RandomEngine &m_engine;
+    PhaseTimes &m_times;
+    unsigned long long &m_fingerprint;
+};
+
+vector<RegressionCase> regressionCorpus()
+{
+    const vector<int> standard = {5, 4, 3, 3, 2};
+    const vector<int> small = {3, 2, 2};
+    const vector<int> wide = {4, 3, 3, 2, 2, 1};
+    const vector<int> large = {5, 4, 4, 3, 3, 3, 2, 2, 2, 2};
+    vector<RegressionCase> corpus = {
+        {"2x3-rowboat/mediocre-mediocre", 2, 3, {2}, "mediocre", "mediocre", 20000},
+        {"6x6-small/awful-mediocre", 6, 6, small, "awful", "mediocre", 10000},
+        {"6x6-small/mediocre-good", 6, 6, small, "mediocre", "good", 10000},
+        {"10x10-standard/awful-good", 10, 10, standard, "awful", "good", 4000},
+        {"10x10-standard/mediocre-good", 10, 10, standard, "mediocre", "good", 4000},
+        {"10x10-standard/good-good", 10, 10, standard, "good", "good", 4000},
+        {"8x14-wide/mediocre-good", 8, 14, wide, "mediocre", "good", 2000},
+        {"20x20-large/mediocre-good", 20, 20, large, "mediocre", "good", 1000},
+    };
+    return corpus;
+}
+
+// helper function
+// play every game of c once, timing the whole pass
+RegressionResult playRegressionPass(const RegressionCase &c)
+{
+    RegressionResult res{c.name, 14695981039346656037ULL, 0, {0, 0, 0, 0, 0}, {0, 0, 0, 0, 0}};
+    auto begin = chrono::steady_clock::now();
+    for (int i = 0; i < c.games; i++)
+    {
+        Game g(c.rows, c.cols);
+        for (size_t k = 0; k < c.shipLengths.size(); k++)
+            g.addShip(c.shipLengths[k], char('A' + k % 26), "ship");
+        seed_seq seed1{unsigned(i), 1u}, seed2{unsigned(i), 2u};
+        RandomEngine engine1(seed1), engine2(seed2);
+        Player *p1 = createPlayer(c.first, c.first, g);
+        Player *p2 = createPlayer(c.second, c.second, g);
+        if (p1 != nullptr && p2 != nullptr)
+        {
+            TimedPlayer first(p1, g, engine1, res.first, res.fingerprint);
+            TimedPlayer second(p2, g, engine2, res.second, res.fingerprint);
+            // alternate who moves first, like the ladder does
+            Player *winner = (i % 2 == 1 ? g.play(&first, &second, false, false)
+                                         : g.play(&second, &first, false, false));
+            first.mix(winner == &first ? 1 : winner == &second ? 2 : 0);
+        }
+        delete p1;
+        delete p2;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    res.gamesPerSecond = c.games / max(seconds, 1e-9);
+    return res;
+}
+
+RegressionResult runRegressionCase(const RegressionCase &c)
+{
+    // the fastest of a few passes is the least disturbed by whatever else the machine is doing
+    const int PASSES = 3;
+    RegressionResult best = playRegressionPass(c);
+    for (int pass = 1; pass < PASSES; pass++)
+    {
+        RegressionResult res = playRegressionPass(c);
+        if (res.gamesPerSecond > best.gamesPerSecond)
+            best = res;
+    }
+    return best;
+}
+
+bool writeRegressionBaseline(const string &path, const vector<RegressionResult> &results)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    out.precision(10);
+    for (const RegressionResult &r : results)
+    {
+        out << r.name << ' ' << r.fingerprint << ' ' << r.gamesPerSecond;
+        for (const PhaseTimes *t : {&r.first, &r.second})
+            out << ' ' << t->placing << ' ' << t->attacking << ' ' << t->recording << ' '
+                << t->attacks << ' ' << t->records;
+        out << '\n';
+    }
+    return bool(out);
+}
+
+bool readRegressionBaseline(const string &path, vector<RegressionResult> &results)
+{
+    ifstream in(path);
+    if (!in)
+        return false;
+    results.clear();
+    RegressionResult r;
+    while (in >> r.name >> r.fingerprint >> r.gamesPerSecond)
+    {
+        for (PhaseTimes *t : {&r.first, &r.second})
+            in >> t->placing >> t->attacking >> t->recording >> t->attacks >> t->records;
+        if (!in)
+            return false;
+        results.push_back(r);
+    }
+    return in.eof();
+}
+
+bool writeRegressionGolden(const string &path, const vector<RegressionResult> &results)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    for (const RegressionResult &r : results)
+        out << r.name << ' ' << r.fingerprint << '\n';
+    return bool(out);
+}
+
+bool readRegressionGolden(const string &path, vector<RegressionResult> &results)
+{
+    ifstream in(path);
+    if (!in)
+        return false;
+    results.clear();
+    RegressionResult r{"", 0, 0, {0, 0, 0, 0, 0}, {0, 0, 0, 0, 0}};
+    while (in >> r.name >> r.fingerprint)
+        results.push_back(r);
+    return in.eof();
+}
@@ -0,0 +1,60 @@
+#ifndef REGRESSION_INCLUDED
+#define REGRESSION_INCLUDED
+
+#include <string>
+#include <vector>
+
+  // One entry of the regression corpus: seeded games between two player
+  // types on one board and fleet
+struct RegressionCase
+{
+    std::string name;
+    int rows;
+    int cols;
+    std::vector<int> shipLengths;
+    std::string first;
+    std::string second;
+    int games;
+};
+
+  // Seconds one side spent in each kind of Player call over a case's games
+struct PhaseTimes
+{
+    double placing;
+    double attacking; // recommendAttack
+    double recording; // recordAttackResult and recordAttackByOpponent
+    long attacks;
+    long records;
+};
+
+struct RegressionResult
+{
+    std::string name;
+    unsigned long long fingerprint; // hash of every shot, its result and every winner
+    double gamesPerSecond;
+    PhaseTimes first;
+    PhaseTimes second;
+};
+
+  // The golden fingerprints of the corpus, kept in the repository, so a
+  // change in any game shows up on any machine.  They hold across standard
+  // libraries because the players draw only through randInt and randInt64.
+const char* const REGRESSION_GOLDEN_FILE = "regress.golden";
+
+  // The fixed corpus: several board sizes and fleets, each played by a few
+  // pairings of the deterministic player types
+std::vector<RegressionCase> regressionCorpus();
+  // Play every game of c on this thread.  Game i seeds each side's random
+  // engine from i, so the fingerprint only changes if some player's choices do.
+RegressionResult runRegressionCase(const RegressionCase& c);
+bool writeRegressionBaseline(const std::string& path,
+                             const std::vector<RegressionResult>& results);
+  // Return false if the file is missing or unreadable
+bool readRegressionBaseline(const std::string& path, std::vector<RegressionResult>& results);
+  // The same for just the names and fingerprints, which don't depend on the
+  // machine; the results read have no times
+bool writeRegressionGolden(const std::string& path,
+                           const std::vector<RegressionResult>& results);
+bool readRegressionGolden(const std::string& path, std::vector<RegressionResult>& results);
+
+#endif // REGRESSION_INCLUDED
@@ -0,0 +1,56 @@
+#ifndef SEATPLAYER_INCLUDED
+#define SEATPLAYER_INCLUDED
+
+#include "Board.h"
+#include "FleetSampler.h"
+#include "Player.h"
+#include "globals.h"
+#include <vector>
+
+  // A SeatPlayer lets another player play from a seat of a paired game,
+  // running every call of the player it wraps on the seat's own random
+  // engine, so a player's luck follows it when the seats are swapped.  If
+  // it is given a layout, it places the seat's fleet itself; otherwise the
+  // wrapped player places it.
+class SeatPlayer : public Player
+{
+  public:
+    SeatPlayer(Player* p, const Game& g, RandomEngine& engine,
+               const std::vector<ShipPlacement>* layout = nullptr)
+     : Player(p->name(), g), m_player(p), m_engine(engine), m_layout(layout)
+    {}
+    virtual bool placeShips(Board& b)
+    {
+        RandomEngineScope scope(m_engine);
+        if (m_layout == nullptr)
+            return m_player->placeShips(b);
+        for (size_t k = 0; k < m_layout->size(); k++)
+            if (!b.placeShip((*m_layout)[k].topOrLeft, k, (*m_layout)[k].dir))
+                return false;
+        return true;
+    }
+    virtual Point recommendAttack()
+    {
+        RandomEngineScope scope(m_engine);
+        return m_player->recommendAttack();
+    }
+    virtual void recordAttackResult(Point p, bool validShot, bool shotHit,
+                                    bool shipDestroyed, int shipId)
+    {
+        RandomEngineScope scope(m_engine);
+        m_player->recordAttackResult(p, validShot, shotHit, shipDestroyed, shipId);
+    }
+    virtual void recordAttackByOpponent(Point p)
+    {
+        RandomEngineScope scope(m_engine);
+        m_player->recordAttackByOpponent(p);
+    }
+    virtual bool hasForfeited() const { return m_player->hasForfeited(); }
+
+  private:
+    Player* m_player;
+    RandomEngine& m_engine;
+    const std::vector<ShipPlacement>* m_layout;
+};
+
+#endif // SEATPLAYER_INCLUDED
@@ -0,0 +1,74 @@
+#include "Sketch.h"
+#include "Game.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+LogHistogram::LogHistogram()
+    : m_counts{}, m_total(0), m_sum(0), m_min(UINT64_MAX), m_max(0)
+{
+}
+
+void LogHistogram::merge(const LogHistogram &other)
+{
+    for (int b = 0; b < NBUCKETS; b++)
+        m_counts[b] += other.m_counts[b];
+    m_total += other.m_total;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+uint64_t LogHistogram::quantile(double q) const
+{
+    if (m_total == 0)
+        return 0;
+    // the rank of the value we want, counting from 1
+    uint64_t rank = std::max<uint64_t>(1, uint64_t(ceil(std::min(std::max(q, 0.0), 1.0) * m_total)));
+    uint64_t seen = 0;
+    int b = 0;
+    while (seen + m_counts[b] < rank)
+        seen += m_counts[b++];
+    if (b < 64)
+        return b;
+    // report the middle of the bucket, but never outside what was seen
+    int high = 6 + (b - 64) / 32;
+    uint64_t width = uint64_t(1) << (high - 5);
+    uint64_t lowest = uint64_t(32 + (b - 64) % 32) << (high - 5);
+    return std::min(std::max(lowest + width / 2, m_min), m_max);
+}
+
+GameSketch::GameSketch(int nCells)
+    : games(0), wins(0), cellHits(nCells, 0)
+{
+}
+
+void GameSketch::add(const GameStats &stats, int s, bool won)
+{
+    games++;
+    if (won)
+    {
+        wins++;
+        shotsToWin.add(stats.shots[s]);
+    }
+    for (uint32_t nanos : stats.moveNanos[s])
+        moveNanos.add(nanos);
+    for (int cell : stats.hits[s])
+        if (cell >= 0 && cell < int(cellHits.size()))
+            cellHits[cell]++;
+}
+
+void GameSketch::merge(const GameSketch &other)
+{
+    games += other.games;
+    wins += other.wins;
+    shotsToWin.merge(other.shotsToWin);
+    moveNanos.merge(other.moveNanos);
+    if (cellHits.size() < other.cellHits.size())
+        cellHits.resize(other.cellHits.size(), 0);
+    for (size_t cell = 0; cell < other.cellHits.size(); cell++)
+        cellHits[cell] += other.cellHits[cell];
+}
@@ -0,0 +1,66 @@
+#ifndef SKETCH_INCLUDED
+#define SKETCH_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+struct GameStats;
+
+  // A LogHistogram counts values in a fixed set of buckets: one per value
+  // below 64, then 32 per power of two, so any quantile it reports is within
+  // about 1.6% of the true one.  It takes the same 15K however many values
+  // it has seen, and two of them merge by adding their counts.
+class LogHistogram
+{
+  public:
+    static const int NBUCKETS = 64 + 58 * 32;
+    LogHistogram();
+    void add(uint64_t value)
+    {
+        m_counts[bucketOf(value)]++;
+        m_total++;
+        m_sum += double(value);
+        if (value < m_min)
+            m_min = value;
+        if (value > m_max)
+            m_max = value;
+    }
+    void merge(const LogHistogram& other);
+    uint64_t count() const { return m_total; }
+    uint64_t min() const { return m_total ? m_min : 0; }
+    uint64_t max() const { return m_max; }
+    double mean() const { return m_total ? m_sum / m_total : 0; }
+      // The value that a fraction q of the values are at or below, or 0 if
+      // there are none
+    uint64_t quantile(double q) const;
+
+  private:
+    static int bucketOf(uint64_t value)
+    {
+        if (value < 64)
+            return int(value);
+        int high = 63 - __builtin_clzll(value);
+        return 64 + (high - 6) * 32 + int((value >> (high - 5)) & 31);
+    }
+    uint64_t m_counts[NBUCKETS];
+    uint64_t m_total;
+    double m_sum;
+    uint64_t m_min;
+    uint64_t m_max;
+};
+
+  // What one player type did over any number of games, in constant memory
+struct GameSketch
+{
+    explicit GameSketch(int nCells = 0);
+    uint64_t games;
+    uint64_t wins;
+    LogHistogram shotsToWin;        // the type's shots in the games it won
+    LogHistogram moveNanos;         // how long each of its recommendAttack calls took
+    std::vector<uint64_t> cellHits; // per cell of the opponent's board, how often it hit there
+      // Add side s of a game, which it won if won is true
+    void add(const GameStats& stats, int s, bool won);
+    void merge(const GameSketch& other);
+};
+
+#endif // SKETCH_INCLUDED
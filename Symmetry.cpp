@@ -0,0 +1,92 @@
+#include "Symmetry.h"
+#include "GameState.h"
+#include "globals.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+BoardSymmetry::BoardSymmetry(int nRows, int nCols)
+    : m_rows(nRows), m_cols(nCols), m_nCells(nRows * nCols), m_count(nRows == nCols ? 8 : 4)
+{
+    // symmetry t mirrors the columns if bit 0 is set, then the rows if bit
+    // 1 is, then swaps rows and columns if bit 2 is (only on a square board)
+    m_maps.resize(m_count * m_nCells);
+    for (int t = 0; t < m_count; t++)
+        for (int r = 0; r < m_rows; r++)
+            for (int c = 0; c < m_cols; c++)
+            {
+                int rr = (t & 2) ? m_rows - 1 - r : r;
+                int cc = (t & 1) ? m_cols - 1 - c : c;
+                if (t & 4)
+                    swap(rr, cc);
+                m_maps[t * m_nCells + r * m_cols + c] = rr * m_cols + cc;
+            }
+    for (int t = 0; t < m_count; t++)
+        for (int u = 0; u < m_count; u++)
+        {
+            bool undoes = true;
+            for (Cell cell = 0; undoes && cell < m_nCells; cell++)
+                undoes = map(map(cell, t), u) == cell;
+            if (undoes)
+                m_inverse[t] = u;
+        }
+}
+
+CellSet BoardSymmetry::map(const CellSet &cells, int t) const
+{
+    if (t == 0)
+        return cells;
+    CellSet image;
+    for (CellSet rest = cells; !rest.empty(); rest.erase(rest.first()))
+        image.insert(map(rest.first(), t));
+    return image;
+}
+
+ShotState BoardSymmetry::map(const ShotState &state, int t) const
+{
+    return ShotState{map(state.shots, t), map(state.hits, t)};
+}
+
+// helper function
+// return true if a comes before b in the order canonical forms are chosen by
+bool comesBefore(const ShotState &a, const ShotState &b)
+{
+    for (int w = 1; w >= 0; w--)
+        if (a.shots.word(w) != b.shots.word(w))
+            return a.shots.word(w) < b.shots.word(w);
+    for (int w = 1; w >= 0; w--)
+        if (a.hits.word(w) != b.hits.word(w))
+            return a.hits.word(w) < b.hits.word(w);
+    return false;
+}
+
+int BoardSymmetry::canonicalize(const ShotState &state, ShotState &canonical) const
+{
+    canonical = state;
+    int best = 0;
+    for (int t = 1; t < m_count; t++)
+    {
+        ShotState image = map(state, t);
+        if (comesBefore(image, canonical))
+        {
+            canonical = image;
+            best = t;
+        }
+    }
+    return best;
+}
+
+const BoardSymmetry &BoardSymmetry::shared(int nRows, int nCols)
+{
+    static mutex symmetriesLock;
+    static std::map<pair<int, int>, unique_ptr<BoardSymmetry>> symmetries;
+    lock_guard<mutex> guard(symmetriesLock);
+    unique_ptr<BoardSymmetry> &symmetry = symmetries[make_pair(nRows, nCols)];
+    if (!symmetry)
+        symmetry.reset(new BoardSymmetry(nRows, nCols));
+    return *symmetry;
+}
@@ -0,0 +1,54 @@
+#ifndef SYMMETRY_INCLUDED
+#define SYMMETRY_INCLUDED
+
+#include "GameState.h"
+#include "globals.h"
+#include <vector>
+
+  // What an attacker knows of the opponent's board: every cell it has shot
+  // at, and which of them hit
+struct ShotState
+{
+    CellSet shots;
+    CellSet hits;
+};
+
+  // The symmetries of an empty nRows by nCols board.  Every board has four:
+  // the identity, the two mirror images and the half turn.  A square board
+  // also has the two quarter turns and the two diagonal reflections.  Shot
+  // states that one of them maps onto another are worth the same to an
+  // attacker, so tables of them (opening books, transposition tables,
+  // solvers) need only keep one of each, the canonical one: the image that
+  // comes first in a fixed order.  Boards must fit a CellSet.
+class BoardSymmetry
+{
+  public:
+    BoardSymmetry(int nRows, int nCols);
+    int rows() const { return m_rows; }
+    int cols() const { return m_cols; }
+      // The number of symmetries, 8 or 4; symmetry 0 is the identity
+    int count() const { return m_count; }
+      // Where symmetry t takes cell
+    Cell map(Cell cell, int t) const { return m_maps[t * m_nCells + cell]; }
+      // The symmetry that undoes t
+    int inverse(int t) const { return m_inverse[t]; }
+    CellSet map(const CellSet& cells, int t) const;
+    ShotState map(const ShotState& state, int t) const;
+      // Put the canonical form of state in canonical and return the symmetry
+      // t that took state there, so map(canonical, inverse(t)) is state and
+      // a cell c of the canonical board is map(c, inverse(t)) on state's
+    int canonicalize(const ShotState& state, ShotState& canonical) const;
+      // Return the symmetries of boards of this size, shared by every game
+      // of that size and kept until the program ends
+    static const BoardSymmetry& shared(int nRows, int nCols);
+
+  private:
+    int m_rows;
+    int m_cols;
+    int m_nCells;
+    int m_count;
+    std::vector<Cell> m_maps; // m_nCells per symmetry
+    int m_inverse[8];
+};
+
+#endif // SYMMETRY_INCLUDED
@@ -0,0 +1,742 @@
+#include "Tournament.h"
+#include "Game.h"
+#include "Board.h"
+#include "FleetSampler.h"
+#include "GameLog.h"
+#include "Player.h"
+#include "Rating.h"
+#include "SeatPlayer.h"
+#include "Trace.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
+#include <new>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace std;
+
+// The table worker processes share with the coordinator.  Each game has one
+// result byte written by the worker that played it, and each worker publishes
+// the index of the next game it will play.
+const unsigned char NOT_PLAYED = 0, FIRST_WON = 1, SECOND_WON = 2, NO_WINNER = 3, CRASHED = 4;
+
+struct ShardTable
+{
+    atomic<long> *next; // per worker
+    atomic<unsigned char> *result; // per game
+    void *memory;
+    size_t size;
+};
+
+class TournamentImpl
+{
+public:
+    TournamentImpl(int nRows, int nCols, bool (*addShips)(Game &), int nThreads);
+    int nThreads() const;
+    void setGameLog(GameLogWriter *log) { m_log = log; }
+    void setSketching(bool on);
+    map<string, GameSketch> sketches() const;
+    vector<PairResult> roundRobin(const vector<string> &types, int gamesPerPair);
+    vector<PairResult> roundRobinSharded(const vector<string> &types, int gamesPerPair,
+                                         int nProcesses, double stallSeconds);
+    SprtResult sprt(const string &first, const string &second, const SprtSettings &settings);
+    PairedResult paired(const string &first, const string &second, int nSeeds, unsigned baseSeed);
+    vector<PlacementResult> placement(const string &placer, const vector<ShipPlacement> *layout,
+                                      const vector<string> &attackers, int nLayouts,
+                                      int gamesPerLayout, unsigned baseSeed,
+                                      vector<vector<ShipPlacement>> *layouts);
+
+private:
+    // play game k between two types from seed on thread t, alternating who
+    // moves first like main does, and log and sketch it unless t is -1;
+    // return 1 if first won, 2 if second won, 0 if the game could not be played
+    int playGame(const string &first, const string &second, int k, uint64_t seed, int t);
+    // play seed's game with first in seat 1 (or seat 2 if swapped); seat 1
+    // moves first.  Return first's score: 1 for a win, 0.5 if nobody won.
+    double playSeatedGame(const string &first, const string &second, unsigned seed,
+                          bool swapped) const;
+    // set layout to the fleet placer lays out from seed; return false if it can't
+    bool placeLayout(const string &placer, unsigned seed, vector<ShipPlacement> &layout) const;
+    // attack layout with attacker using seed's engine for game; return the
+    // shots it took, or -1 if the game could not be set up
+    int shotsToSink(const vector<ShipPlacement> &layout, const string &attacker, unsigned seed,
+                    int game) const;
+    template <class Job>
+    void runParallel(int nJobs, Job job) const;
+    // play games [table.next[worker], end) of a sharded round robin in this process
+    void runShard(const vector<PairResult> &pairs, int gamesPerPair, ShardTable &table,
+                  int worker, long end);
+    int m_rows, m_cols;
+    bool (*m_addShips)(Game &);
+    int m_nThreads;
+    GameLogWriter *m_log;
+    bool m_sketching;
+    vector<map<string, GameSketch>> m_sketches; // per thread, by type
+};
+
+TournamentImpl::TournamentImpl(int nRows, int nCols, bool (*addShips)(Game &), int nThreads)
+    : m_rows(nRows), m_cols(nCols), m_addShips(addShips), m_nThreads(nThreads), m_log(nullptr),
+      m_sketching(false)
+{
+    if (m_nThreads < 1)
+        m_nThreads = max(1u, thread::hardware_concurrency());
+}
+
+void TournamentImpl::setSketching(bool on)
+{
+    m_sketching = on;
+    if (on)
+        m_sketches.assign(m_nThreads, map<string, GameSketch>());
+}
+
+map<string, GameSketch> TournamentImpl::sketches() const
+{
+    map<string, GameSketch> merged;
+    for (const map<string, GameSketch> &perThread : m_sketches)
+        for (const auto &entry : perThread)
+        {
+            auto found = merged.find(entry.first);
+            if (found == merged.end())
+                merged.insert(entry);
+            else
+                found->second.merge(entry.second);
+        }
+    return merged;
+}
+
+int TournamentImpl::nThreads() const
+{
+    return m_nThreads;
+}
+
+int TournamentImpl::playGame(const string &first, const string &second, int k, uint64_t seed, int t)
+{
+    // every game gets its own seed, so a game is the same whichever thread
+    // or process plays it
+    seed_seq seeds{unsigned(seed), unsigned(seed >> 32)};
+    RandomEngine engine(seeds);
+    RandomEngineScope scope(engine);
+    Game g(m_rows, m_cols);
+    if (!m_addShips(g))
+        return 0;
+    Player *p1 = createPlayer(first, first, g);
+    Player *p2 = createPlayer(second, second, g);
+    GameLogWriter *log = t >= 0 ? m_log : nullptr;
+    bool sketched = t >= 0 && m_sketching;
+    GameRecord record;
+    record.stats.timeMoves = sketched;
+    int result = 0;
+    if (p1 != nullptr && p2 != nullptr)
+    {
+        GameStats *stats = (log != nullptr || sketched) ? &record.stats : nullptr;
+        Player *winner = (k % 2 == 1 ? g.play(p1, p2, false, false, stats)
+                                     : g.play(p2, p1, false, false, stats));
+        if (winner == p1)
+            result = 1;
+        else if (winner == p2)
+            result = 2;
+    }
+    bool played = p1 != nullptr && p2 != nullptr;
+    delete p1;
+    delete p2;
+    if (!played)
+        return result;
+    record.firstMover = (k % 2 == 1 ? 0 : 1);
+    if (record.firstMover == 1) // the stats are by move order; the log is by pairing
+        record.stats.swapSides();
+    if (log != nullptr)
+    {
+        record.seed = seed;
+        record.firstType = log->typeIndex(first);
+        record.secondType = log->typeIndex(second);
+        record.winner = result;
+        log->add(record);
+    }
+    if (sketched)
+    {
+        const int nCells = m_rows * m_cols;
+          // try_emplace builds a sketch only the first time a type is seen
+        m_sketches[t].try_emplace(first, nCells).first->second.add(record.stats, 0, result == 1);
+        m_sketches[t].try_emplace(second, nCells).first->second.add(record.stats, 1, result == 2);
+    }
+    return result;
+}
+
+// helper function
+// fill layout with a random placement of g's ships drawn from the active engine
+bool randomLayout(const Game &g, vector<ShipPlacement> &layout)
+{
+    Board b(g);
+    for (int attempt = 0; attempt < 100; attempt++)
+    {
+        b.clear();
+        layout.clear();
+        for (int k = 0; k < g.nShips(); k++)
+        {
+            for (int tries = 0; tries < 100 && int(layout.size()) == k; tries++)
+            {
+                ShipPlacement sp{g.randomPoint(), randInt(2) ? HORIZONTAL : VERTICAL};
+                if (b.placeShip(sp.topOrLeft, k, sp.dir))
+                    layout.push_back(sp);
+            }
+            if (int(layout.size()) == k) // this ship didn't fit, start again
+                break;
+        }
+        if (int(layout.size()) == g.nShips())
+            return true;
+    }
+    return false;
+}
+
+double TournamentImpl::playSeatedGame(const string &first, const string &second, unsigned seed,
+                                      bool swapped) const
+{
+    Game g(m_rows, m_cols);
+    if (!m_addShips(g))
+        return 0.5;
+
+    // both games of a pair rebuild the same layouts and engines from the seed
+    vector<ShipPlacement> layout1, layout2;
+    seed_seq layoutSeed{seed, 0u};
+    RandomEngine layoutEngine(layoutSeed);
+    {
+        RandomEngineScope scope(layoutEngine);
+        if (!randomLayout(g, layout1) || !randomLayout(g, layout2))
+            return 0.5;
+    }
+    seed_seq seed1{seed, 1u}, seed2{seed, 2u};
+    RandomEngine engine1(seed1), engine2(seed2);
+
+    Player *p1 = createPlayer(swapped ? second : first, "seat 1", g);
+    Player *p2 = createPlayer(swapped ? first : second, "seat 2", g);
+    double score = 0.5;
+    if (p1 != nullptr && p2 != nullptr)
+    {
+        SeatPlayer seat1(p1, g, engine1, &layout1);
+        SeatPlayer seat2(p2, g, engine2, &layout2);
+        Player *winner = g.play(&seat1, &seat2, false, false);
+        if (winner != nullptr)
+            score = ((winner == &seat1) != swapped) ? 1 : 0;
+    }
+    delete p1;
+    delete p2;
+    return score;
+}
+
+bool TournamentImpl::placeLayout(const string &placer, unsigned seed,
+                                 vector<ShipPlacement> &layout) const
+{
+    layout.clear();
+    Game g(m_rows, m_cols);
+    if (!m_addShips(g))
+        return false;
+    Board b(g);
+    Player *p = createPlayer(placer, placer, g);
+    bool placed;
+    {
+        seed_seq layoutSeed{seed, 0u};
+        RandomEngine layoutEngine(layoutSeed);
+        RandomEngineScope scope(layoutEngine);
+        placed = p != nullptr && p->placeShips(b);
+    }
+    delete p;
+    layout.resize(g.nShips());
+    for (int k = 0; placed && k < g.nShips(); k++)
+        placed = b.findShip(k, layout[k].topOrLeft, layout[k].dir);
+    if (!placed)
+        layout.clear();
+    return placed;
+}
+
+int TournamentImpl::shotsToSink(const vector<ShipPlacement> &layout, const string &attacker,
+                                unsigned seed, int game) const
+{
+    TraceSpan span("attackLayout");
+    Game g(m_rows, m_cols);
+    if (!m_addShips(g))
+        return -1;
+    Player *p = createPlayer(attacker, attacker, g);
+    if (p == nullptr)
+        return -1;
+    seed_seq attackSeed{seed, 1u + unsigned(game)};
+    RandomEngine engine(attackSeed);
+    RandomEngineScope scope(engine);
+    int shots = ::shotsToSink(p, g, layout);
+    delete p;
+    return shots;
+}
+
+// helper function
+// run job(thread, i) for every i in [0, nJobs) on all threads.  Threads claim
+// chunks that shrink as the work runs out (guided self-scheduling), so the
+// expensive jobs at the front are spread out and the cheap ones at the back
+// fill in whatever imbalance is left.
+template <class Job>
+void TournamentImpl::runParallel(int nJobs, Job job) const
+{
+    atomic<int> next(0);
+    auto worker = [&](int t) {
+        if (tracing())
+            traceThreadName("worker " + to_string(t));
+        while (true)
+        {
+            int remaining = nJobs - next.load(memory_order_relaxed);
+            int chunk = max(1, remaining / (4 * m_nThreads));
+            int start = next.fetch_add(chunk, memory_order_relaxed);
+            if (start >= nJobs)
+                return;
+            int end = min(nJobs, start + chunk);
+            for (int i = start; i < end; i++)
+                job(t, i);
+        }
+    };
+    vector<thread> threads;
+    for (int t = 1; t < m_nThreads; t++)
+        threads.emplace_back(worker, t);
+    worker(0);
+    for (thread &th : threads)
+        th.join();
+}
+
+vector<PairResult> TournamentImpl::roundRobin(const vector<string> &types, int gamesPerPair)
+{
+    vector<PairResult> results;
+    for (size_t i = 0; i < types.size(); i++)
+        for (size_t j = i + 1; j < types.size(); j++)
+            results.push_back(PairResult{types[i], types[j], 0, 0, 0, 0});
+    const int nPairs = results.size();
+    if (nPairs == 0 || gamesPerPair < 1)
+        return results;
+
+    // each thread counts games, first wins and second wins per pair on its own
+    vector<vector<int>> counts(m_nThreads, vector<int>(3 * nPairs, 0));
+    auto record = [&](int t, int pair, int result) {
+        counts[t][3 * pair]++;
+        if (result != 0)
+            counts[t][3 * pair + result]++;
+    };
+
+    // play game 1 of every pair first and time it, so we know which pairings are slow
+    vector<double> cost(nPairs);
+    runParallel(nPairs, [&](int t, int pair) {
+        auto begin = chrono::steady_clock::now();
+        record(t, pair, playGame(results[pair].first, results[pair].second, 1,
+                                 long(pair) * gamesPerPair, t));
+        cost[pair] = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    });
+
+    // then schedule the rest longest pairing first
+    vector<int> order(nPairs);
+    iota(order.begin(), order.end(), 0);
+    sort(order.begin(), order.end(), [&](int a, int b) { return cost[a] > cost[b]; });
+    const int rest = gamesPerPair - 1;
+    runParallel(nPairs * rest, [&](int t, int i) {
+        int pair = order[i / rest];
+        int k = 2 + i % rest;
+        record(t, pair, playGame(results[pair].first, results[pair].second, k,
+                                 long(pair) * gamesPerPair + k - 1, t));
+    });
+
+    for (int pair = 0; pair < nPairs; pair++)
+    {
+        for (int t = 0; t < m_nThreads; t++)
+        {
+            results[pair].games += counts[t][3 * pair];
+            results[pair].firstWins += counts[t][3 * pair + 1];
+            results[pair].secondWins += counts[t][3 * pair + 2];
+        }
+    }
+    return results;
+}
+
+SprtResult TournamentImpl::sprt(const string &first, const string &second, const SprtSettings &settings)
+{
+    SprtResult res{0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    res.lowerBound = log(settings.beta / (1 - settings.alpha));
+    res.upperBound = log((1 - settings.beta) / settings.alpha);
+
+    // batches are kept even so both players move first equally often
+    int batch = settings.batchSize > 0 ? settings.batchSize : max(16, 4 * m_nThreads);
+    batch += batch % 2;
+    vector<int> counts(3 * m_nThreads);
+    while (res.decision == 0 && res.games < settings.maxGames)
+    {
+        int n = min(batch, settings.maxGames - res.games);
+        int firstGame = res.games + 1;
+        fill(counts.begin(), counts.end(), 0);
+        runParallel(n, [&](int t, int i) {
+            counts[3 * t]++;
+            int result = playGame(first, second, firstGame + i, firstGame + i - 1, t);
+            if (result != 0)
+                counts[3 * t + result]++;
+        });
+        for (int t = 0; t < m_nThreads; t++)
+        {
+            res.games += counts[3 * t];
+            res.firstWins += counts[3 * t + 1];
+            res.secondWins += counts[3 * t + 2];
+        }
+
+        res.llr = sprtLlr(res.firstWins, res.secondWins, settings.elo0, settings.elo1);
+        if (res.llr >= res.upperBound)
+            res.decision = 1;
+        else if (res.llr <= res.lowerBound)
+            res.decision = -1;
+    }
+    estimateElo(res.firstWins, res.secondWins, res.elo, res.eloLow, res.eloHigh);
+    return res;
+}
+
+PairedResult TournamentImpl::paired(const string &first, const string &second, int nSeeds,
+                                    unsigned baseSeed)
+{
+    PairedResult res{0, 0, 0, 0.5, 0, 0, 0, 0, 0};
+    if (nSeeds < 1)
+        return res;
+
+    // per thread: pairs, first wins, second wins, sum of pair scores, sum of squares
+    vector<vector<double>> sums(m_nThreads, vector<double>(5, 0));
+    runParallel(nSeeds, [&](int t, int i) {
+        unsigned seed = baseSeed + i;
+        double a = playSeatedGame(first, second, seed, false);
+        double b = playSeatedGame(first, second, seed, true);
+        vector<double> &sum = sums[t];
+        sum[0]++;
+        sum[1] += (a == 1) + (b == 1);
+        sum[2] += (a == 0) + (b == 0);
+        sum[3] += (a + b) / 2;
+        sum[4] += (a + b) * (a + b) / 4;
+    });
+
+    double total = 0, totalSquares = 0;
+    for (const vector<double> &sum : sums)
+    {
+        res.pairs += sum[0];
+        res.firstWins += sum[1];
+        res.secondWins += sum[2];
+        total += sum[3];
+        totalSquares += sum[4];
+    }
+    double n = res.pairs;
+    res.score = total / n;
+    double pairVariance = n > 1 ? (totalSquares - n * res.score * res.score) / (n - 1) : 0.25;
+    res.variance = max(pairVariance, 0.0) / n;
+    res.unpairedVariance = res.score * (1 - res.score) / (2 * n);
+
+    // turn the paired interval on the score into one on the Elo difference
+    double err = 1.96 * sqrt(res.variance);
+    auto clamp = [](double p) { return min(max(p, 1e-6), 1 - 1e-6); };
+    res.elo = scoreToElo(clamp(res.score));
+    res.eloLow = scoreToElo(clamp(res.score - err));
+    res.eloHigh = scoreToElo(clamp(res.score + err));
+    return res;
+}
+
+vector<PlacementResult> TournamentImpl::placement(const string &placer,
+                                                  const vector<ShipPlacement> *layout,
+                                                  const vector<string> &attackers, int nLayouts,
+                                                  int gamesPerLayout, unsigned baseSeed,
+                                                  vector<vector<ShipPlacement>> *layouts)
+{
+    const int nAttackers = attackers.size();
+    vector<PlacementResult> results;
+    for (const string &attacker : attackers)
+        results.push_back(PlacementResult{attacker, 0, 0, 0, 0, 0, -1, 0, vector<LayoutResult>()});
+    if (layouts != nullptr)
+        layouts->clear();
+    if (nAttackers == 0 || nLayouts < 1 || gamesPerLayout < 1)
+        return results;
+
+    // lay out every fleet once, then every job writes its own slot, so the
+    // threads share nothing
+    vector<vector<ShipPlacement>> fleets(nLayouts);
+    if (layout != nullptr)
+        fleets.assign(nLayouts, *layout);
+    else
+        runParallel(nLayouts, [&](int, int l) { placeLayout(placer, baseSeed + l, fleets[l]); });
+    const int nJobs = nLayouts * gamesPerLayout * nAttackers;
+    vector<int> shots(nJobs);
+    runParallel(nJobs, [&](int, int i) {
+        int attacker = i % nAttackers;
+        int game = i / nAttackers % gamesPerLayout;
+        int layoutIndex = i / nAttackers / gamesPerLayout;
+        shots[i] = shotsToSink(fleets[layoutIndex], attackers[attacker], baseSeed + layoutIndex, game);
+    });
+
+    const int limit = m_rows * m_cols * 10;
+    for (int a = 0; a < nAttackers; a++)
+    {
+        PlacementResult &res = results[a];
+        double total = 0, totalSquares = 0;
+        for (int l = 0; l < nLayouts; l++)
+        {
+            LayoutResult layoutRes{0, 0, 0, 0};
+            double layoutTotal = 0, layoutSquares = 0;
+            for (int k = 0; k < gamesPerLayout; k++)
+            {
+                int n = shots[(l * gamesPerLayout + k) * nAttackers + a];
+                if (n < 0)
+                    continue;
+                if (res.games == 0 || n < res.fewest)
+                    res.fewest = n;
+                if (layoutRes.games == 0 || n < layoutRes.fewest)
+                    layoutRes.fewest = n;
+                res.games++;
+                res.unfinished += (n >= limit);
+                total += n;
+                totalSquares += double(n) * n;
+                layoutRes.games++;
+                layoutTotal += n;
+                layoutSquares += double(n) * n;
+            }
+            double n = layoutRes.games;
+            if (n > 0)
+                layoutRes.mean = layoutTotal / n;
+            if (n > 1)
+                layoutRes.variance = max(0.0, (layoutSquares - n * layoutRes.mean * layoutRes.mean) / (n - 1));
+            if (n > 0 && (res.worstLayout < 0 || layoutRes.mean < res.worstLayoutMean))
+            {
+                res.worstLayoutMean = layoutRes.mean;
+                res.worstLayout = l;
+            }
+            res.layouts.push_back(layoutRes);
+        }
+        double n = res.games;
+        if (n > 0)
+            res.mean = total / n;
+        if (n > 1)
+            res.variance = max(0.0, (totalSquares - n * res.mean * res.mean) / (n - 1));
+    }
+    if (layouts != nullptr)
+        layouts->swap(fleets);
+    return results;
+}
+
+void TournamentImpl::runShard(const vector<PairResult> &pairs, int gamesPerPair, ShardTable &table,
+                              int worker, long end)
+{
+#ifdef __linux__
+    long nCores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nCores > 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(worker % nCores, &cpus);
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+    }
+#endif
+    for (long game = table.next[worker].load(); game < end; game++)
+    {
+        // a forked worker's copy of the log would write over the parent's,
+        // and its sketches would never make it back
+        const PairResult &pair = pairs[game / gamesPerPair];
+        int result = playGame(pair.first, pair.second, 1 + game % gamesPerPair, game, -1);
+        table.result[game].store(result == 0 ? NO_WINNER : result, memory_order_release);
+        table.next[worker].store(game + 1, memory_order_release);
+    }
+}
+
+vector<PairResult> TournamentImpl::roundRobinSharded(const vector<string> &types, int gamesPerPair,
+                                                     int nProcesses, double stallSeconds)
+{
+    vector<PairResult> results;
+    for (size_t i = 0; i < types.size(); i++)
+        for (size_t j = i + 1; j < types.size(); j++)
+            results.push_back(PairResult{types[i], types[j], 0, 0, 0, 0});
+    const long nGames = long(results.size()) * gamesPerPair;
+    if (nGames <= 0)
+        return results;
+    nProcesses = max(1, int(min<long>(nProcesses, nGames)));
+
+    static_assert(atomic<long>::is_always_lock_free && atomic<unsigned char>::is_always_lock_free,
+                  "the shared table needs address-free atomics");
+    ShardTable table;
+    table.size = nProcesses * sizeof(atomic<long>) + nGames;
+    table.memory = mmap(nullptr, table.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (table.memory == MAP_FAILED)
+        return vector<PairResult>();
+    table.next = static_cast<atomic<long> *>(table.memory);
+    table.result = reinterpret_cast<atomic<unsigned char> *>(table.next + nProcesses);
+    for (int w = 0; w < nProcesses; w++)
+        new (&table.next[w]) atomic<long>(0);
+    for (long game = 0; game < nGames; game++)
+        new (&table.result[game]) atomic<unsigned char>(NOT_PLAYED);
+
+    vector<long> begin(nProcesses + 1);
+    for (int w = 0; w <= nProcesses; w++)
+        begin[w] = nGames * w / nProcesses;
+    vector<pid_t> pids(nProcesses, -1);
+    vector<long> lastProgress(nProcesses);
+    vector<chrono::steady_clock::time_point> lastChange(nProcesses);
+
+    // start a worker on the rest of w's range; if there can't be one, the
+    // games left in the range are lost as if it had crashed
+    auto spawn = [&](int w) {
+        pid_t pid = fork();
+        if (pid == 0)
+        {
+            runShard(results, gamesPerPair, table, w, begin[w + 1]);
+            _exit(0);
+        }
+        pids[w] = pid;
+        if (pid < 0)
+        {
+            for (long game = table.next[w].load(); game < begin[w + 1]; game++)
+                table.result[game].store(CRASHED);
+            table.next[w].store(begin[w + 1]);
+            return false;
+        }
+        lastProgress[w] = table.next[w].load();
+        lastChange[w] = chrono::steady_clock::now();
+        return true;
+    };
+    int running = 0;
+    for (int w = 0; w < nProcesses; w++)
+    {
+        table.next[w].store(begin[w]);
+        if (spawn(w))
+            running++;
+    }
+    if (running == 0)
+    {
+        munmap(table.memory, table.size);
+        return vector<PairResult>();
+    }
+
+    // watch the workers until every one has finished its range
+    while (running > 0)
+    {
+        usleep(10000);
+        for (int w = 0; w < nProcesses; w++)
+        {
+            if (pids[w] <= 0)
+                continue;
+            long next = table.next[w].load(memory_order_acquire);
+            auto now = chrono::steady_clock::now();
+            if (next != lastProgress[w])
+            {
+                lastProgress[w] = next;
+                lastChange[w] = now;
+            }
+            else if (chrono::duration<double>(now - lastChange[w]).count() > stallSeconds)
+                kill(pids[w], SIGKILL); // a hung bot counts as a crash
+
+            int status;
+            if (waitpid(pids[w], &status, WNOHANG) != pids[w])
+                continue;
+            pids[w] = -1;
+            running--;
+            next = table.next[w].load(memory_order_acquire);
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && next >= begin[w + 1])
+                continue;
+            // the worker died; give up on the game it was playing and carry on after it
+            if (next < begin[w + 1] && table.result[next].load() == NOT_PLAYED)
+                table.result[next].store(CRASHED);
+            table.next[w].store(next + 1);
+            if (next + 1 < begin[w + 1] && spawn(w))
+                running++;
+        }
+    }
+
+    for (long game = 0; game < nGames; game++)
+    {
+        PairResult &res = results[game / gamesPerPair];
+        unsigned char result = table.result[game].load();
+        if (result == CRASHED || result == NOT_PLAYED)
+        {
+            res.crashes++;
+            continue;
+        }
+        res.games++;
+        if (result == FIRST_WON)
+            res.firstWins++;
+        else if (result == SECOND_WON)
+            res.secondWins++;
+    }
+    munmap(table.memory, table.size);
+    return results;
+}
+
+//******************** Tournament functions ***************************
+
+// These functions simply delegate to TournamentImpl's functions.
+
+Tournament::Tournament(int nRows, int nCols, bool (*addShips)(Game &), int nThreads)
+{
+    m_impl = new TournamentImpl(nRows, nCols, addShips, nThreads);
+}
+
+Tournament::~Tournament()
+{
+    delete m_impl;
+}
+
+int Tournament::nThreads() const
+{
+    return m_impl->nThreads();
+}
+
+void Tournament::setGameLog(GameLogWriter *log)
+{
+    m_impl->setGameLog(log);
+}
+
+void Tournament::setSketching(bool on)
+{
+    m_impl->setSketching(on);
+}
+
+map<string, GameSketch> Tournament::sketches() const
+{
+    return m_impl->sketches();
+}
+
+vector<PairResult> Tournament::roundRobin(const vector<string> &types, int gamesPerPair)
+{
+    return m_impl->roundRobin(types, gamesPerPair);
+}
+
+vector<PairResult> Tournament::roundRobinSharded(const vector<string> &types, int gamesPerPair,
+                                                 int nProcesses, double stallSeconds)
+{
+    return m_impl->roundRobinSharded(types, gamesPerPair, nProcesses, stallSeconds);
+}
+
+SprtResult Tournament::sprt(const string &first, const string &second, const SprtSettings &settings)
+{
+    return m_impl->sprt(first, second, settings);
+}
+
+PairedResult Tournament::paired(const string &first, const string &second, int nSeeds,
+                                unsigned baseSeed)
+{
+    return m_impl->paired(first, second, nSeeds, baseSeed);
+}
+
+vector<PlacementResult> Tournament::placement(const string &placer, const vector<string> &attackers,
+                                              int nLayouts, int gamesPerLayout, unsigned baseSeed,
+                                              vector<vector<ShipPlacement>> *layouts)
+{
+    return m_impl->placement(placer, nullptr, attackers, nLayouts, gamesPerLayout, baseSeed,
+                             layouts);
+}
+
+vector<PlacementResult> Tournament::placement(const vector<ShipPlacement> &layout,
+                                              const vector<string> &attackers, int gamesPerLayout,
+                                              unsigned baseSeed)
+{
+    return m_impl->placement("", &layout, attackers, 1, gamesPerLayout, baseSeed, nullptr);
+}
@@ -0,0 +1,151 @@
+#ifndef TOURNAMENT_INCLUDED
+#define TOURNAMENT_INCLUDED
+
+#include "Sketch.h"
+#include <map>
+#include <string>
+#include <vector>
+
+class Game;
+class GameLogWriter;
+class TournamentImpl;
+struct ShipPlacement;
+
+  // The results of all the games played between two player types
+struct PairResult
+{
+    std::string first;
+    std::string second;
+    int games;
+    int firstWins;
+    int secondWins;
+    int crashes; // games lost to a crashed or hung worker process
+};
+
+  // The hypotheses and error rates for a sequential probability ratio test
+  // that the first player is elo1 rather than elo0 points stronger than the second
+struct SprtSettings
+{
+    double elo0 = 0;
+    double elo1 = 20;
+    double alpha = 0.05;   // chance of accepting elo1 when elo0 is true
+    double beta = 0.05;    // chance of accepting elo0 when elo1 is true
+    int batchSize = 0;     // games per parallel batch; 0 picks one from nThreads
+    int maxGames = 100000; // give up undecided after this many games
+};
+
+struct SprtResult
+{
+    int games;
+    int firstWins;
+    int secondWins;
+    double llr;        // log-likelihood ratio after the last batch
+    double lowerBound; // accept elo0 at or below this
+    double upperBound; // accept elo1 at or above this
+    int decision;      // 1 accepted elo1, -1 accepted elo0, 0 undecided
+    double elo;        // estimated strength difference, with a 95% interval
+    double eloLow;
+    double eloHigh;
+};
+
+  // The results of paired games: each seed is played twice with the players
+  // swapping seats, and a seat keeps its fleet layout and random stream
+struct PairedResult
+{
+    int pairs;
+    int firstWins;
+    int secondWins;
+    double score;            // first's mean score per pair of games
+    double variance;         // variance of score, estimated from the pairs
+    double unpairedVariance; // variance of score if the games were independent
+    double elo;              // estimated strength difference, with a 95% interval
+    double eloLow;
+    double eloHigh;
+};
+
+  // How many shots one attacker needed to sink every ship of one layout
+struct LayoutResult
+{
+    int games;       // 0 if the layout couldn't be placed
+    double mean;
+    double variance;
+    int fewest;
+};
+
+  // How many shots one attacker needed to sink every ship of the fleets a
+  // placement was tested with
+struct PlacementResult
+{
+    std::string attacker;
+    int games;
+    double mean;            // shots to sink the whole fleet
+    double variance;
+    int fewest;             // the worst case for the fleet over all games
+    double worstLayoutMean; // the lowest mean shots of any one layout
+    int worstLayout;        // and which layout that was
+    int unfinished;         // games given up after rows * cols * 10 shots, counted as that many
+    std::vector<LayoutResult> layouts; // per layout
+};
+
+class Tournament
+{
+  public:
+      // Every game is played on an nRows by nCols board set up by addShips.
+      // nThreads == 0 uses one thread per hardware core.
+    Tournament(int nRows, int nCols, bool (*addShips)(Game&), int nThreads = 0);
+    ~Tournament();
+    int nThreads() const;
+      // Add every game roundRobin and sprt play from now on to log, or stop
+      // logging if it is null.  The log must know every type they are given.
+    void setGameLog(GameLogWriter* log);
+      // Start (or stop) keeping a GameSketch per player type of every game
+      // roundRobin and sprt play, with each thread keeping its own.  Starting
+      // throws away what was kept before.
+    void setSketching(bool on);
+      // The sketches kept so far, merged over the threads
+    std::map<std::string, GameSketch> sketches() const;
+      // Game k of pair i (counting from 0 over all pairs) is seeded from
+      // i * gamesPerPair + k, both here and in roundRobinSharded
+    std::vector<PairResult> roundRobin(const std::vector<std::string>& types,
+                                       int gamesPerPair);
+      // Play the same round robin in nProcesses worker processes, each pinned
+      // to a core and playing a disjoint range of seeded games.  A worker that
+      // crashes, or makes no progress for stallSeconds, is replaced and only
+      // the game it was playing is lost; if it can't be replaced, the rest of
+      // its range is lost.  These games aren't logged or sketched.  Return an
+      // empty vector if no worker could be started at all.
+    std::vector<PairResult> roundRobinSharded(const std::vector<std::string>& types,
+                                              int gamesPerPair, int nProcesses,
+                                              double stallSeconds = 60);
+      // Play batches of games between first and second until the test decides
+    SprtResult sprt(const std::string& first, const std::string& second,
+                    const SprtSettings& settings);
+      // Play seeds [baseSeed, baseSeed + nSeeds) as mirrored pairs of games.
+      // Placements come from the seed rather than the players, so only the
+      // players' attacking is compared.
+    PairedResult paired(const std::string& first, const std::string& second,
+                        int nSeeds, unsigned baseSeed);
+      // Lay out nLayouts fleets with placer's placeShips and have every
+      // attacker attack each of them gamesPerLayout times on its own.  Layout
+      // i is placed from seed baseSeed + i and every attacker gets the same
+      // random streams, so the attackers are tested on the same fleets.  If
+      // layouts isn't null, it is filled with the layouts, indexed by ship
+      // id; one that couldn't be placed is empty.
+    std::vector<PlacementResult> placement(const std::string& placer,
+                                           const std::vector<std::string>& attackers,
+                                           int nLayouts, int gamesPerLayout,
+                                           unsigned baseSeed = 1,
+                                           std::vector<std::vector<ShipPlacement>>* layouts = nullptr);
+      // The same for a single candidate layout
+    std::vector<PlacementResult> placement(const std::vector<ShipPlacement>& layout,
+                                           const std::vector<std::string>& attackers,
+                                           int gamesPerLayout, unsigned baseSeed = 1);
+      // We prevent a Tournament object from being copied or assigned
+    Tournament(const Tournament&) = delete;
+    Tournament& operator=(const Tournament&) = delete;
+
+  private:
+    TournamentImpl* m_impl;
+};
+
+#endif // TOURNAMENT_INCLUDED
@@ -0,0 +1,216 @@
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// One span as a ring holds it
+struct TraceEvent
+{
+    const char *name;
+    int label;
+    uint64_t begin; // nanoseconds on the steady clock
+    uint64_t end;
+};
+
+// The spans one thread recorded.  Only that thread writes to it; written
+// counts every span ever recorded, so the ring holds the last
+// min(written, events.size()) of them.  A ring is never freed: when its
+// thread ends it goes to the next thread that records a span, which keeps
+// the number of rings at the most threads ever running at once.
+struct TraceRing
+{
+    vector<TraceEvent> events;
+    atomic<uint64_t> written;
+    int lane; // its row of the timeline
+    string name;
+    bool inUse;
+};
+
+// Everything the rings share, behind one lock that recording never takes
+// once a thread has its ring
+struct TraceRegistry
+{
+    mutex lock;
+    vector<unique_ptr<TraceRing>> rings;
+    map<string, int> labelIds;
+    vector<string> labels;
+    int ringSize = 1 << 16;
+    uint64_t start = 0;
+};
+
+// helper function
+TraceRegistry &registry()
+{
+    static TraceRegistry reg;
+    return reg;
+}
+
+// Hands the calling thread's ring back when the thread ends
+struct RingHolder
+{
+    TraceRing *ring = nullptr;
+    ~RingHolder()
+    {
+        if (ring != nullptr)
+        {
+            lock_guard<mutex> guard(registry().lock);
+            ring->inUse = false;
+        }
+    }
+};
+
+// helper function
+// return the calling thread's ring, taking a free one or making one the
+// first time the thread records a span
+TraceRing &threadRing()
+{
+    thread_local RingHolder holder;
+    if (holder.ring != nullptr)
+        return *holder.ring;
+    TraceRegistry &reg = registry();
+    lock_guard<mutex> guard(reg.lock);
+    for (unique_ptr<TraceRing> &ring : reg.rings)
+        if (!ring->inUse)
+        {
+            holder.ring = ring.get();
+            break;
+        }
+    if (holder.ring == nullptr)
+    {
+        reg.rings.emplace_back(new TraceRing);
+        holder.ring = reg.rings.back().get();
+        holder.ring->events.resize(reg.ringSize);
+        holder.ring->written = 0;
+        holder.ring->lane = reg.rings.size();
+    }
+    holder.ring->inUse = true;
+    return *holder.ring;
+}
+
+void traceEnd(const char *name, uint64_t begin, int label)
+{
+    if (begin == 0)
+        return;
+    uint64_t end = chrono::duration_cast<chrono::nanoseconds>(
+                       chrono::steady_clock::now().time_since_epoch()).count();
+    TraceRing &ring = threadRing();
+    uint64_t n = ring.written.load(memory_order_relaxed);
+    ring.events[n % ring.events.size()] = TraceEvent{name, label, begin, end};
+    ring.written.store(n + 1, memory_order_release);
+}
+
+int traceLabel(const string &text)
+{
+    TraceRegistry &reg = registry();
+    lock_guard<mutex> guard(reg.lock);
+    auto found = reg.labelIds.emplace(text, reg.labels.size());
+    if (found.second)
+        reg.labels.push_back(text);
+    return found.first->second;
+}
+
+void traceThreadName(const string &name)
+{
+    if (!tracing())
+        return;
+    TraceRing &ring = threadRing();
+    lock_guard<mutex> guard(registry().lock);
+    ring.name = name;
+}
+
+void startTrace(int eventsPerThread)
+{
+    TraceRegistry &reg = registry();
+    {
+        lock_guard<mutex> guard(reg.lock);
+        reg.ringSize = max(1, eventsPerThread);
+        for (unique_ptr<TraceRing> &ring : reg.rings)
+        {
+            ring->events.assign(reg.ringSize, TraceEvent());
+            ring->written = 0;
+            ring->name.clear();
+        }
+        reg.labelIds.clear();
+        reg.labels.clear();
+        reg.start = chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    traceActive().store(true, memory_order_relaxed);
+}
+
+// helper function
+// write text as a JSON string
+void writeJsonString(ostream &out, const string &text)
+{
+    out << '"';
+    for (unsigned char ch : text)
+    {
+        if (ch == '"' || ch == '\\')
+            out << '\\' << ch;
+        else if (ch < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", ch);
+            out << escaped;
+        }
+        else
+            out << ch;
+    }
+    out << '"';
+}
+
+bool writeTrace(const string &path)
+{
+    traceActive().store(false, memory_order_relaxed);
+    TraceRegistry &reg = registry();
+    lock_guard<mutex> guard(reg.lock);
+    ofstream out(path);
+    if (!out)
+        return false;
+    // complete events ("ph":"X") in microseconds from the start of the trace
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    char number[64];
+    for (const unique_ptr<TraceRing> &ring : reg.rings)
+    {
+        uint64_t written = ring->written.load(memory_order_acquire);
+        if (written == 0)
+            continue;
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << ring->lane << ",\"args\":{\"name\":";
+        writeJsonString(out, ring->name.empty() ? "thread " + to_string(ring->lane) : ring->name);
+        out << "}}";
+        first = false;
+        uint64_t size = ring->events.size();
+        for (uint64_t i = written > size ? written - size : 0; i < written; i++)
+        {
+            const TraceEvent &e = ring->events[i % size];
+            if (e.name == nullptr || e.begin < reg.start)
+                continue;
+            snprintf(number, sizeof(number), "%.3f,\"dur\":%.3f", (e.begin - reg.start) / 1000.0,
+                     (e.end - e.begin) / 1000.0);
+            out << ",\n{\"name\":";
+            writeJsonString(out, e.name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->lane << ",\"ts\":" << number;
+            if (e.label >= 0 && e.label < int(reg.labels.size()))
+            {
+                out << ",\"args\":{\"label\":";
+                writeJsonString(out, reg.labels[e.label]);
+                out << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    return bool(out);
+}
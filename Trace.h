@@ -0,0 +1,76 @@
+#ifndef TRACE_INCLUDED
+#define TRACE_INCLUDED
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+  // A timeline of what every thread spent its time on, written in the
+  // Chrome trace format that chrome://tracing and ui.perfetto.dev open.
+  // Each thread records spans into a ring buffer of its own, so recording
+  // takes no lock, and while tracing is off a span costs one relaxed load.
+  // A ring keeps only its latest spans once it is full.
+
+  // The switch startTrace and writeTrace turn on and off
+inline std::atomic<bool>& traceActive()
+{
+    static std::atomic<bool> active(false);
+    return active;
+}
+
+  // Return true while spans are being recorded
+inline bool tracing()
+{
+    return traceActive().load(std::memory_order_relaxed);
+}
+
+  // Return the time a span starts, or 0 if tracing is off
+inline uint64_t traceBegin()
+{
+    if (!tracing())
+        return 0;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+  // Record a span called name from begin until now on this thread's ring,
+  // unless begin is 0.  name must outlive the trace, like a string literal.
+  // label is a number from traceLabel, or -1 for none.
+void traceEnd(const char* name, uint64_t begin, int label = -1);
+
+  // Return a number standing for text, the same one every time text is
+  // asked for until the trace is written.  This takes a lock, so ask once
+  // per game or player rather than once per span.
+int traceLabel(const std::string& text);
+
+  // Name the calling thread's row of the timeline
+void traceThreadName(const std::string& name);
+
+  // Start recording, with eventsPerThread spans kept per thread, throwing
+  // away any spans recorded before
+void startTrace(int eventsPerThread = 1 << 16);
+
+  // Stop recording and write every thread's spans to path; return false if
+  // it can't be written.  Threads should have finished their work first.
+bool writeTrace(const std::string& path);
+
+  // A span from construction to destruction
+class TraceSpan
+{
+  public:
+    TraceSpan(const char* name, int label = -1)
+     : m_name(name), m_label(label), m_begin(traceBegin())
+    {}
+    ~TraceSpan() { if (m_begin != 0) traceEnd(m_name, m_begin, m_label); }
+      // We prevent a TraceSpan object from being copied or assigned
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+  private:
+    const char* m_name;
+    int m_label;
+    uint64_t m_begin;
+};
+
+#endif // TRACE_INCLUDED
@@ -0,0 +1,301 @@
+#include "Tuner.h"
+#include "Game.h"
+#include "Player.h"
+#include "SeatPlayer.h"
+#include "Trace.h"
+#include "globals.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+class TunerImpl
+{
+public:
+    TunerImpl(int nRows, int nCols, bool (*addShips)(Game &), int nThreads);
+    int nThreads() const { return m_nThreads; }
+    bool setCache(const string &path);
+    TuneResult tune(const string &type, const string &opponent, const TuneSettings &settings,
+                    void (*report)(const TuneResult &best));
+
+private:
+    // play seed's pair of games between player and opponent; return player's
+    // points in half points, 0 to 4
+    int playPair(const string &player, const string &opponent, unsigned seed) const;
+    // score each candidate against opponent on seeds [0, nSeeds) as mean
+    // points per game, playing only the pairs not already in the cache
+    vector<double> evaluate(const vector<string> &candidates, const string &opponent,
+                            int nSeeds, TuneResult &progress);
+    // the cache key of seed's pair of games between player and opponent
+    string key(const string &player, const string &opponent, unsigned seed) const;
+    int m_rows, m_cols;
+    bool (*m_addShips)(Game &);
+    int m_nThreads;
+    string m_board; // the board and fleet, so results for other games don't mix
+    map<string, int> m_cache;
+    string m_cachePath;
+};
+
+TunerImpl::TunerImpl(int nRows, int nCols, bool (*addShips)(Game &), int nThreads)
+    : m_rows(nRows), m_cols(nCols), m_addShips(addShips), m_nThreads(nThreads)
+{
+    if (m_nThreads < 1)
+        m_nThreads = max(1u, thread::hardware_concurrency());
+    Game g(m_rows, m_cols);
+    m_addShips(g);
+    m_board = to_string(m_rows) + "x" + to_string(m_cols);
+    for (int k = 0; k < g.nShips(); k++)
+        m_board += (k == 0 ? "/" : ",") + to_string(g.shipLength(k));
+    if (g.shotsPerTurn() != 1)
+        m_board += "/salvo" + to_string(g.shotsPerTurn());
+}
+
+bool TunerImpl::setCache(const string &path)
+{
+    // a line is a key, a tab, and the points, where a key is four fields
+    // separated by tabs, since player types may hold spaces
+    ifstream in(path);
+    string line;
+    while (getline(in, line))
+    {
+        size_t tab = line.rfind('\t');
+        if (tab == string::npos || tab + 1 == line.size())
+            return false;
+        m_cache[line.substr(0, tab)] = atoi(line.c_str() + tab + 1);
+    }
+    if (in.bad())
+        return false;
+    ofstream out(path, ios::app);
+    if (!out)
+        return false;
+    m_cachePath = path;
+    return true;
+}
+
+string TunerImpl::key(const string &player, const string &opponent, unsigned seed) const
+{
+    // "seats" marks pairs played with an engine per side, so results cached
+    // before that don't mix with them
+    return m_board + "/seats\t" + player + '\t' + opponent + '\t' + to_string(seed);
+}
+
+int TunerImpl::playPair(const string &player, const string &opponent, unsigned seed) const
+{
+    Game g(m_rows, m_cols);
+    if (!m_addShips(g))
+        return 0;
+    int points = 0;
+    for (int k = 0; k < 2; k++)
+    {
+        // each side draws from an engine of its own, seeded the same in both
+        // games of the pair, so swapping the seats swaps the luck too
+        seed_seq playerSeed{seed, 1u}, opponentSeed{seed, 2u};
+        RandomEngine playerEngine(playerSeed), opponentEngine(opponentSeed);
+        Player *p = createPlayer(player, player, g);
+        Player *o = createPlayer(opponent, opponent, g);
+        if (p != nullptr && o != nullptr)
+        {
+            SeatPlayer ps(p, g, playerEngine);
+            SeatPlayer os(o, g, opponentEngine);
+            Player *winner = (k == 0 ? g.play(&ps, &os, false, false) : g.play(&os, &ps, false, false));
+            if (winner == &ps)
+                points += 2;
+            else if (winner == nullptr)
+                points += 1;
+        }
+        delete p;
+        delete o;
+    }
+    return points;
+}
+
+vector<double> TunerImpl::evaluate(const vector<string> &candidates, const string &opponent,
+                                   int nSeeds, TuneResult &progress)
+{
+    TraceSpan span("scoreCandidates");
+    // list the pairs nobody has played yet, once each even if several
+    // candidates have the same settings
+    vector<pair<string, unsigned>> jobs;
+    set<string> listed;
+    for (const string &player : candidates)
+    {
+        if (!listed.insert(player).second)
+            continue;
+        for (int s = 0; s < nSeeds; s++)
+        {
+            progress.evaluations++;
+            if (m_cache.count(key(player, opponent, s)) != 0)
+                progress.cached++;
+            else
+                jobs.emplace_back(player, s);
+        }
+    }
+
+    vector<int> points(jobs.size());
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < jobs.size(); i = next++)
+            points[i] = playPair(jobs[i].first, opponent, jobs[i].second);
+    };
+    vector<thread> threads;
+    for (int t = 1; t < m_nThreads; t++)
+        threads.emplace_back(worker);
+    worker();
+    for (thread &th : threads)
+        th.join();
+
+    ofstream out;
+    if (!m_cachePath.empty())
+        out.open(m_cachePath, ios::app);
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        string k = key(jobs[i].first, opponent, jobs[i].second);
+        m_cache[k] = points[i];
+        if (out)
+            out << k << '\t' << points[i] << '\n';
+    }
+
+    vector<double> scores;
+    for (const string &player : candidates)
+    {
+        long total = 0;
+        for (int s = 0; s < nSeeds; s++)
+            total += m_cache[key(player, opponent, s)];
+        scores.push_back(total / (4.0 * nSeeds));
+    }
+    return scores;
+}
+
+TuneResult TunerImpl::tune(const string &type, const string &opponent, const TuneSettings &settings,
+                           void (*report)(const TuneResult &best))
+{
+    TuneResult best;
+    best.score = 0;
+    best.generation = 0;
+    best.evaluations = 0;
+    best.cached = 0;
+    vector<PlayerParam> params = playerParams(type);
+    {
+        Game g(m_rows, m_cols);
+        m_addShips(g);
+        Player *p = createPlayer(type, type, g);
+        Player *o = createPlayer(opponent, opponent, g);
+        bool ok = p != nullptr && o != nullptr && !p->isHuman() && !o->isHuman();
+        delete p;
+        delete o;
+        if (!ok || params.empty())
+            return best;
+    }
+    int population = max(2, settings.population);
+    int nSeeds = max(1, settings.seeds);
+    int nElites = max(1, population / 8);
+    RandomEngine engine(settings.searchSeed);
+    auto uniform = [&](int low, int high) { return uniform_int_distribution<>(low, high)(engine); };
+    auto chance = [&](double p) { return uniform_real_distribution<>(0, 1)(engine) < p; };
+
+    // start from the defaults and candidates drawn from the whole range
+    vector<vector<int>> genomes;
+    vector<int> defaults;
+    for (const PlayerParam &param : params)
+        defaults.push_back(param.value);
+    genomes.push_back(defaults);
+    while (int(genomes.size()) < population)
+    {
+        vector<int> genome;
+        for (const PlayerParam &param : params)
+            genome.push_back(uniform(param.low, param.high));
+        genomes.push_back(genome);
+    }
+
+    for (int generation = 1; generation <= settings.generations; generation++)
+    {
+        vector<string> candidates;
+        for (const vector<int> &genome : genomes)
+            candidates.push_back(playerTypeWith(type, genome));
+        vector<double> scores = evaluate(candidates, opponent, nSeeds, best);
+        vector<int> order(genomes.size());
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [&](int a, int b) { return scores[a] > scores[b]; });
+        if (best.values.empty() || scores[order[0]] > best.score)
+        {
+            best.values = genomes[order[0]];
+            best.player = candidates[order[0]];
+            best.score = scores[order[0]];
+        }
+        best.generation = generation;
+        if (report != nullptr)
+            report(best);
+        if (generation == settings.generations)
+            break;
+
+        // the best few go on unchanged; the rest are children of parents
+        // picked by two-way tournaments, with each parameter taken from
+        // either parent and sometimes nudged
+        auto pick = [&]() {
+            int a = uniform(0, population - 1), b = uniform(0, population - 1);
+            return scores[a] >= scores[b] ? a : b;
+        };
+        vector<vector<int>> next;
+        for (int i = 0; i < nElites; i++)
+            next.push_back(genomes[order[i]]);
+        while (int(next.size()) < population)
+        {
+            const vector<int> &mother = genomes[pick()];
+            const vector<int> &father = genomes[pick()];
+            vector<int> child;
+            for (size_t i = 0; i < params.size(); i++)
+            {
+                int value = chance(0.5) ? mother[i] : father[i];
+                if (chance(settings.mutation))
+                {
+                    double spread = max(1.0, (params[i].high - params[i].low) / 10.0);
+                    int step = int(lround(normal_distribution<>(0, spread)(engine)));
+                    value += step != 0 ? step : (chance(0.5) ? 1 : -1);
+                }
+                child.push_back(min(params[i].high, max(params[i].low, value)));
+            }
+            next.push_back(child);
+        }
+        genomes.swap(next);
+    }
+    return best;
+}
+
+//******************** Tuner functions *******************************
+
+// These functions simply delegate to TunerImpl's functions.
+
+Tuner::Tuner(int nRows, int nCols, bool (*addShips)(Game &), int nThreads)
+{
+    m_impl = new TunerImpl(nRows, nCols, addShips, nThreads);
+}
+
+Tuner::~Tuner()
+{
+    delete m_impl;
+}
+
+int Tuner::nThreads() const
+{
+    return m_impl->nThreads();
+}
+
+bool Tuner::setCache(const string &path)
+{
+    return m_impl->setCache(path);
+}
+
+TuneResult Tuner::tune(const string &type, const string &opponent, const TuneSettings &settings,
+                       void (*report)(const TuneResult &best))
+{
+    return m_impl->tune(type, opponent, settings, report);
+}
@@ -0,0 +1,63 @@
+#ifndef TUNER_INCLUDED
+#define TUNER_INCLUDED
+
+#include <string>
+#include <vector>
+
+class Game;
+class TunerImpl;
+
+struct TuneSettings
+{
+    int generations = 10;
+    int population = 16;
+    int seeds = 200;         // seeds every candidate is scored on, two games each
+    double mutation = 0.3;   // chance each parameter of a child is nudged
+    unsigned searchSeed = 1; // seeds the search's own choices, not the games
+};
+
+  // The best settings a search has found so far
+struct TuneResult
+{
+    std::vector<int> values; // in the order of playerParams(type)
+    std::string player;      // the createPlayer type with those settings
+    double score;            // mean points per game against the opponent, 0 to 1
+    int generation;
+    long evaluations;        // (settings, seed) pairs scored so far
+    long cached;             // how many of those came from the cache
+};
+
+  // A Tuner searches the parameters of a player type (see playerParams) for
+  // the settings that do best against an opponent, with a genetic algorithm
+  // whose fitness is seeded games.  Every candidate plays the same seeds,
+  // and each seed is a pair of games with the players changing seats, so
+  // candidates are compared on equal terms.  The result of every (settings,
+  // seed) pair can be kept in a file, so a search that is run again, longer
+  // or with more candidates only plays the games it hasn't played before.
+class Tuner
+{
+  public:
+      // Every game is played on an nRows by nCols board set up by addShips.
+      // nThreads == 0 uses one thread per hardware core.
+    Tuner(int nRows, int nCols, bool (*addShips)(Game&), int nThreads = 0);
+    ~Tuner();
+    int nThreads() const;
+      // Read the results already in path and add new ones to it from now on;
+      // return false if it exists but can't be read, or can't be written
+    bool setCache(const std::string& path);
+      // Search type's parameters for the settings that score best against
+      // opponent, calling report (if it isn't null) after every generation.
+      // The result has no values if type has no parameters or the players
+      // can't be made.
+    TuneResult tune(const std::string& type, const std::string& opponent,
+                    const TuneSettings& settings,
+                    void (*report)(const TuneResult& best) = nullptr);
+      // We prevent a Tuner object from being copied or assigned
+    Tuner(const Tuner&) = delete;
+    Tuner& operator=(const Tuner&) = delete;
+
+  private:
+    TunerImpl* m_impl;
+};
+
+#endif // TUNER_INCLUDED
@@ -1,10 +1,11 @@
 #ifndef GLOBALS_INCLUDED
 #define GLOBALS_INCLUDED
 
+#include <cstdint>
 #include <random>
 
-const int MAXROWS = 10;
-const int MAXCOLS = 10;
+const int MAXROWS = 1000;
+const int MAXCOLS = 1000;
 
 enum Direction {
     HORIZONTAL, VERTICAL
@@ -19,15 +20,88 @@ class Point
     int c;
 };
 
-  // Return a uniformly distributed random int from 0 to limit-1
+  // A cell of a board as a single index, r * cols + c; see CellGrid.h
+typedef int Cell;
+const Cell NOCELL = -1;
+
+  // The four ways out of a cell, in the order CellGrid's tables use
+enum Heading {
+    NORTH, EAST, SOUTH, WEST
+};
+
+  // What became of one shot of a salvo
+struct ShotResult
+{
+    bool valid;     // false if it was off the board or at a cell already attacked
+    bool hit;
+    bool destroyed; // it sank the ship it hit
+    int shipId;     // only meaningful if hit
+};
+
+typedef std::mt19937 RandomEngine;
+
+  // Return the engine randInt draws from on the calling thread.  Each thread
+  // starts with its own randomly seeded engine so games can run in parallel.
+inline RandomEngine*& activeRandomEngine()
+{
+    thread_local RandomEngine defaultEngine(std::random_device{}());
+    thread_local RandomEngine* active = &defaultEngine;
+    return active;
+}
+
+  // While a RandomEngineScope exists, randInt on its thread draws from the
+  // engine it was given.  This lets each player keep its own random stream.
+class RandomEngineScope
+{
+  public:
+    RandomEngineScope(RandomEngine& engine)
+     : m_saved(activeRandomEngine())
+    {
+        activeRandomEngine() = &engine;
+    }
+    ~RandomEngineScope() { activeRandomEngine() = m_saved; }
+    RandomEngineScope(const RandomEngineScope&) = delete;
+    RandomEngineScope& operator=(const RandomEngineScope&) = delete;
+
+  private:
+    RandomEngine* m_saved;
+};
+
+  // Return a uniformly distributed random int from 0 to limit-1.  The
+  // engine's 32-bit output is scaled here (multiply, and draw again in the
+  // rare case that would be biased) rather than by
+  // std::uniform_int_distribution, whose algorithm differs between standard
+  // libraries, so seeded games come out the same with any of them.
 inline int randInt(int limit)
 {
-    static std::random_device rd;
-    static std::mt19937 generator(rd());
     if (limit < 1)
         limit = 1;
-    std::uniform_int_distribution<> distro(0, limit-1);
-    return distro(generator);
+    RandomEngine& engine = *activeRandomEngine();
+    const uint32_t range = limit;
+    uint64_t scaled = uint64_t(uint32_t(engine())) * range;
+    if (uint32_t(scaled) < range)
+    {
+        const uint32_t threshold = -range % range; // 2^32 mod range
+        while (uint32_t(scaled) < threshold)
+            scaled = uint64_t(uint32_t(engine())) * range;
+    }
+    return int(scaled >> 32);
+}
+
+  // The same for a 64-bit limit, from two of the engine's outputs
+inline uint64_t randInt64(uint64_t limit)
+{
+    if (limit < 1)
+        limit = 1;
+    RandomEngine& engine = *activeRandomEngine();
+    const uint64_t threshold = -limit % limit; // 2^64 mod limit
+    while (true)
+    {
+        uint64_t high = uint32_t(engine());
+        uint64_t drawn = high << 32 | uint32_t(engine());
+        if (drawn >= threshold)
+            return drawn % limit;
+    }
 }
 
 #endif // GLOBALS_INCLUDED
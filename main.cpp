@@ -1,23 +1,1010 @@
+#include "FixedGame.h"
+#include "FleetSampler.h"
 #include "Game.h"
+#include "GameLog.h"
+#include "LayoutCorpus.h"
+#include "LayoutSearch.h"
+#include "MatchServer.h"
+#include "OpeningBook.h"
 #include "Player.h"
+#include "Tournament.h"
+#include "Tuner.h"
+#include "Rating.h"
+#include "Regression.h"
+#include "Sketch.h"
+#include "Trace.h"
+#include "globals.h"
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <iomanip>
+#include <sstream>
 #include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <map>
 
 using namespace std;
 
 bool addStandardShips(Game &g)
 {
-    return g.addShip(5, 'A', "aircraft carrier") &&
-           g.addShip(4, 'B', "battleship") &&
-           g.addShip(3, 'D', "destroyer") &&
-           g.addShip(3, 'S', "submarine") &&
-           g.addShip(2, 'P', "patrol boat");
+    return StandardGame::addShips(g);
 }
 
-int main()
+bool addSalvoShips(Game &g)
+{
+    g.setShotsPerTurn(0); // a shot per ship still afloat
+    return addStandardShips(g);
+}
+
+// helper function
+// return true if every type names a computer player createPlayer can make
+bool checkTypes(const vector<string> &types)
+{
+    Game g(10, 10);
+    addStandardShips(g);
+    for (const string &type : types)
+    {
+        Player *p = createPlayer(type, type, g);
+        if (p == nullptr || p->isHuman())
+        {
+            cout << "Unknown computer player type " << type << endl;
+            delete p;
+            return false;
+        }
+        delete p;
+    }
+    return true;
+}
+
+// helper function
+// rate types from the results of their games, print the ratings and write
+// them to csvFile; return the exit status
+int reportRatings(const vector<string> &types, const vector<PairResult> &results,
+                  const string &csvFile)
+{
+    vector<Rating> ratings = computeRatings(types, results);
+    cout << fixed << setprecision(1);
+    for (size_t i = 0; i < ratings.size(); i++)
+        cout << setw(3) << i + 1 << ". " << setw(12) << left << ratings[i].type << right
+             << setw(8) << ratings[i].elo << "  [" << ratings[i].ciLow << ", "
+             << ratings[i].ciHigh << "]" << endl;
+    if (!writeRatingsCsv(csvFile, ratings))
+    {
+        cout << "Could not write " << csvFile << endl;
+        return 1;
+    }
+    cout << "Ratings written to " << csvFile << endl;
+    return 0;
+}
+
+// ladder [gamesPerPair [csvFile [type ...]]]
+// salvo [gamesPerPair [csvFile [type ...]]]
+// play every pair of player types against each other in games set up by
+// addShips and rank them
+int runLadder(int argc, char *argv[], bool (*addShips)(Game &), string csvFile)
+{
+    int gamesPerPair = argc > 2 ? atoi(argv[2]) : 1000;
+    if (argc > 3)
+        csvFile = argv[3];
+    vector<string> types;
+    for (int i = 4; i < argc; i++)
+        types.push_back(argv[i]);
+    if (types.empty())
+        types = defaultPlayerTypes();
+    if (gamesPerPair < 1)
+    {
+        cout << "The number of games per pair must be at least 1" << endl;
+        return 1;
+    }
+    if (!checkTypes(types))
+        return 1;
+
+    Tournament t(10, 10, addShips);
+    cout << "Playing " << gamesPerPair << " games for each pair of " << types.size()
+         << " player types on " << t.nThreads() << " threads" << endl;
+    vector<PairResult> results = t.roundRobin(types, gamesPerPair);
+    for (const PairResult &res : results)
+        cout << "  " << res.first << " " << res.firstWins << " - " << res.secondWins
+             << " " << res.second << endl;
+
+    return reportRatings(types, results, csvFile);
+}
+
+// shards nProcesses [gamesPerPair [csvFile [type ...]]]
+// the same as ladder, but with the games split over worker processes
+int runShards(int argc, char *argv[])
+{
+    int nProcesses = argc > 2 ? atoi(argv[2]) : 0;
+    if (nProcesses < 1)
+    {
+        cout << "usage: shards nProcesses [gamesPerPair [csvFile [type ...]]]" << endl;
+        return 1;
+    }
+    int gamesPerPair = argc > 3 ? atoi(argv[3]) : 1000;
+    string csvFile = argc > 4 ? argv[4] : "ladder.csv";
+    vector<string> types;
+    for (int i = 5; i < argc; i++)
+        types.push_back(argv[i]);
+    if (types.empty())
+        types = defaultPlayerTypes();
+    if (gamesPerPair < 1)
+    {
+        cout << "The number of games per pair must be at least 1" << endl;
+        return 1;
+    }
+    if (!checkTypes(types))
+        return 1;
+
+    Tournament t(10, 10, addStandardShips);
+    cout << "Playing " << gamesPerPair << " games for each pair of " << types.size()
+         << " player types in " << nProcesses << " processes" << endl;
+    vector<PairResult> results = t.roundRobinSharded(types, gamesPerPair, nProcesses);
+    if (results.empty() && types.size() > 1)
+    {
+        cout << "Could not start any worker processes" << endl;
+        return 1;
+    }
+    for (const PairResult &res : results)
+    {
+        cout << "  " << res.first << " " << res.firstWins << " - " << res.secondWins
+             << " " << res.second;
+        if (res.crashes > 0)
+            cout << "  (" << res.crashes << " games lost to crashes)";
+        cout << endl;
+    }
+
+    return reportRatings(types, results, csvFile);
+}
+
+// sprt first second [elo0 elo1 [alpha beta [maxGames]]]
+// play first against second until a sequential test decides which Elo bound holds
+int runSprt(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        cout << "usage: sprt first second [elo0 elo1 [alpha beta [maxGames]]]" << endl;
+        return 1;
+    }
+    vector<string> types = {argv[2], argv[3]};
+    if (!checkTypes(types))
+        return 1;
+    SprtSettings settings;
+    if (argc > 5)
+    {
+        settings.elo0 = atof(argv[4]);
+        settings.elo1 = atof(argv[5]);
+    }
+    if (argc > 7)
+    {
+        settings.alpha = atof(argv[6]);
+        settings.beta = atof(argv[7]);
+    }
+    if (argc > 8)
+        settings.maxGames = atoi(argv[8]);
+    if (settings.elo0 >= settings.elo1 || settings.alpha <= 0 || settings.alpha >= 1 ||
+        settings.beta <= 0 || settings.beta >= 1 || settings.maxGames < 1)
+    {
+        cout << "Need elo0 < elo1, 0 < alpha, beta < 1 and maxGames >= 1" << endl;
+        return 1;
+    }
+
+    Tournament t(10, 10, addStandardShips);
+    SprtResult res = t.sprt(types[0], types[1], settings);
+    cout << fixed << setprecision(2);
+    cout << types[0] << " " << res.firstWins << " - " << res.secondWins << " " << types[1]
+         << " after " << res.games << " games" << endl;
+    cout << "LLR " << res.llr << " with bounds [" << res.lowerBound << ", "
+         << res.upperBound << "]" << endl;
+    if (res.decision > 0)
+        cout << "Accepted H1: " << types[0] << " is at least " << settings.elo1;
+    else if (res.decision < 0)
+        cout << "Accepted H0: " << types[0] << " is at most " << settings.elo0;
+    else
+        cout << "No decision: " << types[0] << " is between " << settings.elo0 << " and "
+             << settings.elo1;
+    cout << " Elo stronger (alpha " << settings.alpha << ", beta " << settings.beta << ")" << endl;
+    cout << "Estimated difference " << res.elo << " Elo, 95% interval [" << res.eloLow
+         << ", " << res.eloHigh << "]" << endl;
+    return 0;
+}
+
+// paired first second [nSeeds [baseSeed]]
+// play every seed twice with the seats swapped and compare the two players
+int runPaired(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        cout << "usage: paired first second [nSeeds [baseSeed]]" << endl;
+        return 1;
+    }
+    vector<string> types = {argv[2], argv[3]};
+    if (!checkTypes(types))
+        return 1;
+    int nSeeds = argc > 4 ? atoi(argv[4]) : 1000;
+    unsigned baseSeed = argc > 5 ? strtoul(argv[5], nullptr, 10) : 1;
+    if (nSeeds < 1)
+    {
+        cout << "The number of seeds must be at least 1" << endl;
+        return 1;
+    }
+
+    Tournament t(10, 10, addStandardShips);
+    PairedResult res = t.paired(types[0], types[1], nSeeds, baseSeed);
+    cout << fixed << setprecision(4);
+    cout << types[0] << " " << res.firstWins << " - " << res.secondWins << " " << types[1]
+         << " over " << res.pairs << " mirrored pairs" << endl;
+    cout << "Paired score " << res.score << ", standard error " << sqrt(res.variance)
+         << " (independent games would give " << sqrt(res.unpairedVariance) << ")" << endl;
+    if (res.variance > 0)
+        cout << "Variance reduction " << setprecision(2)
+             << res.unpairedVariance / res.variance << "x" << endl;
+    cout << setprecision(1) << "Estimated difference " << res.elo << " Elo, 95% interval ["
+         << res.eloLow << ", " << res.eloHigh << "]" << endl;
+    return 0;
+}
+
+// helper function
+// read a layout written as r,c,h/r,c,v/... with one ship per entry
+bool parseLayout(const string &text, vector<ShipPlacement> &layout)
+{
+    istringstream in(text);
+    string ship;
+    while (getline(in, ship, '/'))
+    {
+        int r, c;
+        char comma1, comma2, dir;
+        istringstream fields(ship);
+        if (!(fields >> r >> comma1 >> c >> comma2 >> dir) || comma1 != ',' || comma2 != ',' ||
+            (dir != 'h' && dir != 'v'))
+            return false;
+        layout.push_back(ShipPlacement{Point(r, c), dir == 'h' ? HORIZONTAL : VERTICAL});
+    }
+    return !layout.empty();
+}
+
+// helper function
+// write each attacker's results on each layout to path as CSV
+bool writePlacementCsv(const string &path, const vector<PlacementResult> &results,
+                       const vector<vector<ShipPlacement>> &layouts)
+{
+    ofstream out(path);
+    if (!out)
+        return false;
+    out << "layout,attacker,games,mean,sd,fewest,placement" << '\n';
+    for (size_t l = 0; l < layouts.size(); l++)
+        for (const PlacementResult &res : results)
+        {
+            const LayoutResult &lr = res.layouts[l];
+            if (lr.games == 0)
+                continue;
+            out << l << ',' << res.attacker << ',' << lr.games << ',' << lr.mean << ','
+                << sqrt(lr.variance) << ',' << lr.fewest << ",layout:"
+                << LayoutSearch::layoutText(layouts[l]) << '\n';
+        }
+    return bool(out);
+}
+
+// placement placer [nLayouts [gamesPerLayout [attacker ...]]]
+// measure how many shots attackers need to sink the fleets placer lays out;
+// placer is a player type or layout:r,c,h/r,c,v/... for one candidate layout
+int runPlacement(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cout << "usage: placement placer [nLayouts [gamesPerLayout [attacker ...]]]" << endl;
+        return 1;
+    }
+    string placer = argv[2];
+    int nLayouts = argc > 3 ? atoi(argv[3]) : 100;
+    int gamesPerLayout = argc > 4 ? atoi(argv[4]) : 20;
+    vector<string> attackers;
+    for (int i = 5; i < argc; i++)
+        attackers.push_back(argv[i]);
+    if (attackers.empty())
+        attackers = defaultPlayerTypes();
+    if (nLayouts < 1 || gamesPerLayout < 1)
+    {
+        cout << "The numbers of layouts and games must be at least 1" << endl;
+        return 1;
+    }
+    if (!checkTypes(attackers))
+        return 1;
+
+    Tournament t(10, 10, addStandardShips);
+    vector<PlacementResult> results;
+    vector<vector<ShipPlacement>> layouts;
+    if (placer.compare(0, 7, "layout:") == 0)
+    {
+        vector<ShipPlacement> layout;
+        if (!parseLayout(placer.substr(7), layout))
+        {
+            cout << "A layout is r,c,h or r,c,v for each ship, separated by /" << endl;
+            return 1;
+        }
+        nLayouts = 1;
+        results = t.placement(layout, attackers, gamesPerLayout);
+    }
+    else
+    {
+        if (!checkTypes(vector<string>{placer}))
+            return 1;
+        results = t.placement(placer, attackers, nLayouts, gamesPerLayout, 1, &layouts);
+    }
+
+    cout << "Shots to sink " << nLayouts << " layouts by " << placer << ", "
+         << gamesPerLayout << " attacks on each" << endl;
+    cout << fixed << setprecision(1);
+    for (const PlacementResult &res : results)
+    {
+        if (res.games == 0)
+        {
+            cout << "  " << res.attacker << ": no games could be set up" << endl;
+            continue;
+        }
+        cout << "  " << setw(10) << left << res.attacker << right << "  mean " << setw(6)
+             << res.mean << "  sd " << setw(5) << sqrt(res.variance) << "  fewest "
+             << setw(3) << res.fewest << "  worst layout " << res.worstLayout << " (mean "
+             << res.worstLayoutMean << ")";
+        if (res.unfinished > 0)
+            cout << "  " << res.unfinished << " games unfinished";
+        cout << endl;
+        if (!layouts.empty())
+            cout << "              worst layout:" << LayoutSearch::layoutText(layouts[res.worstLayout])
+                 << endl;
+    }
+    if (!layouts.empty())
+    {
+        if (!writePlacementCsv("placement.csv", results, layouts))
+        {
+            cout << "Could not write placement.csv" << endl;
+            return 1;
+        }
+        cout << "Results for each layout written to placement.csv" << endl;
+    }
+    return 0;
+}
+
+// helper function
+// print how hard the hardest layout found so far is
+void reportHarden(int step, double hardest)
+{
+    cout << "  step " << setw(5) << step << "  hardest " << setprecision(2) << hardest
+         << " shots" << endl;
+}
+
+// harden attacker [steps [chains [gamesPerLayout [bookFile [cacheFile]]]]]
+// search for the fleet layouts attacker needs the most shots to sink and
+// write them as a placement book
+int runHarden(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cout << "usage: harden attacker [steps [chains [gamesPerLayout [bookFile [cacheFile]]]]]" << endl;
+        return 1;
+    }
+    string attacker = argv[2];
+    LayoutSearchSettings settings;
+    if (argc > 3)
+        settings.steps = atoi(argv[3]);
+    if (argc > 4)
+        settings.chains = atoi(argv[4]);
+    if (argc > 5)
+        settings.gamesPerLayout = atoi(argv[5]);
+    string bookFile = argc > 6 ? argv[6] : "book.bin";
+    string cacheFile = argc > 7 ? argv[7] : "harden.cache";
+    if (settings.steps < 1 || settings.chains < 1 || settings.gamesPerLayout < 1)
+    {
+        cout << "The numbers of steps, chains and games must be at least 1" << endl;
+        return 1;
+    }
+    if (!checkTypes(vector<string>{attacker}))
+        return 1;
+
+    LayoutSearch search(10, 10, addStandardShips);
+    if (!search.setCache(cacheFile))
+    {
+        cout << "Could not use " << cacheFile << " as a cache" << endl;
+        return 1;
+    }
+    cout << "Annealing " << settings.chains << " chains for " << settings.steps << " steps against "
+         << attacker << ", " << settings.gamesPerLayout << " attacks per layout, on "
+         << search.nThreads() << " threads" << endl;
+    cout << fixed;
+    vector<HardLayout> hardest = search.search(attacker, settings, reportHarden);
+    if (hardest.empty())
+    {
+        cout << "No layouts could be scored" << endl;
+        return 1;
+    }
+    cout << "Hardest layouts (mean shots in the search, then on fresh attacks):" << endl;
+    vector<vector<ShipPlacement>> book;
+    for (const HardLayout &hard : hardest)
+    {
+        cout << "  " << setprecision(2) << setw(6) << hard.shots << "  " << setw(6)
+             << hard.validatedShots << "  layout:" << LayoutSearch::layoutText(hard.layout) << endl;
+        book.push_back(hard.layout);
+    }
+    Game g(10, 10);
+    addStandardShips(g);
+    if (!LayoutCorpus::write(g, bookFile, book))
+    {
+        cout << "Could not write " << bookFile << endl;
+        return 1;
+    }
+    cout << "Placement book written to " << bookFile << endl;
+    return 0;
+}
+
+// regress [check|record|golden [file [maxSlowdown]]]
+// play the regression corpus; check that every game comes out as in the
+// golden fingerprints and, if there is a timing baseline in file, that
+// nothing got much slower; or record a timing baseline in file; or write
+// new golden fingerprints to file
+int runRegress(int argc, char *argv[])
+{
+    string mode = argc > 2 ? argv[2] : "check";
+    string file = argc > 3 ? argv[3] : (mode == "golden" ? REGRESSION_GOLDEN_FILE : "regress.txt");
+    double maxSlowdown = argc > 4 ? atof(argv[4]) : 0.2;
+    if ((mode != "check" && mode != "record" && mode != "golden") || maxSlowdown <= 0 ||
+        maxSlowdown >= 1)
+    {
+        cout << "usage: regress [check|record|golden [file [maxSlowdown]]], 0 < maxSlowdown < 1"
+             << endl;
+        return 1;
+    }
+    map<string, const RegressionResult *> golden, before;
+    vector<RegressionResult> goldenResults, baseline;
+    if (mode == "check")
+    {
+        if (!readRegressionGolden(REGRESSION_GOLDEN_FILE, goldenResults))
+        {
+            cout << "Could not read " << REGRESSION_GOLDEN_FILE
+                 << "; run regress from the top of the repository" << endl;
+            return 1;
+        }
+        if (!readRegressionBaseline(file, baseline))
+            cout << "No timing baseline in " << file << ", so only the games are checked" << endl;
+    }
+    for (const RegressionResult &r : goldenResults)
+        golden[r.name] = &r;
+    for (const RegressionResult &r : baseline)
+        before[r.name] = &r;
+    // the corpus pins its own players, so no layout corpus or opening book
+    // opened for the command line may change how they play
+    LayoutCorpus::closeShared();
+    OpeningBook::closeShared();
+
+    // per player type: games, its phase times now, and its phase times now
+    // and in the baseline over just the cases the baseline has
+    struct TypeTimes
+    {
+        int games = 0;
+        int comparedGames = 0;
+        PhaseTimes now{0, 0, 0, 0, 0};
+        PhaseTimes compared{0, 0, 0, 0, 0};
+        PhaseTimes then{0, 0, 0, 0, 0};
+    };
+    auto add = [](PhaseTimes &sum, const PhaseTimes &t) {
+        sum.placing += t.placing;
+        sum.attacking += t.attacking;
+        sum.recording += t.recording;
+        sum.attacks += t.attacks;
+        sum.records += t.records;
+    };
+    map<string, TypeTimes> types;
+    // the one test of a slowdown, for cases and player types alike
+    auto tooSlow = [maxSlowdown](double seconds, double baselineSeconds) {
+        return seconds * (1 - maxSlowdown) > baselineSeconds;
+    };
+
+    bool ok = true;
+    vector<RegressionResult> results;
+    cout << fixed << setprecision(0);
+    for (const RegressionCase &c : regressionCorpus())
+    {
+        RegressionResult res = runRegressionCase(c);
+        results.push_back(res);
+        cout << "  " << setw(32) << left << c.name << right << setw(9) << res.gamesPerSecond
+             << " games/s";
+        if (mode == "check")
+        {
+            auto found = golden.find(c.name);
+            if (found == golden.end())
+            {
+                cout << "  not in " << REGRESSION_GOLDEN_FILE;
+                ok = false;
+            }
+            else if (res.fingerprint != found->second->fingerprint)
+            {
+                cout << "  GAMES CHANGED";
+                ok = false;
+            }
+            auto timed = before.find(c.name);
+            if (timed != before.end())
+            {
+                const RegressionResult &old = *timed->second;
+                cout << "  (baseline " << old.gamesPerSecond << ")";
+                if (tooSlow(1 / res.gamesPerSecond, 1 / old.gamesPerSecond))
+                {
+                    cout << "  TOO SLOW";
+                    ok = false;
+                }
+                add(types[c.first].then, old.first);
+                add(types[c.second].then, old.second);
+                add(types[c.first].compared, res.first);
+                add(types[c.second].compared, res.second);
+                types[c.first].comparedGames += c.games;
+                types[c.second].comparedGames += c.games;
+            }
+        }
+        cout << endl;
+        types[c.first].games += c.games;
+        types[c.second].games += c.games;
+        add(types[c.first].now, res.first);
+        add(types[c.second].now, res.second);
+    }
+
+    if (mode != "check")
+    {
+        if (!(mode == "record" ? writeRegressionBaseline(file, results)
+                               : writeRegressionGolden(file, results)))
+        {
+            cout << "Could not write " << file << endl;
+            return 1;
+        }
+        cout << (mode == "record" ? "Baseline" : "Golden fingerprints") << " written to " << file
+             << endl;
+        return 0;
+    }
+
+    // time per game in each phase, for each player type
+    cout << setprecision(2);
+    for (const auto &entry : types)
+    {
+        const TypeTimes &t = entry.second;
+        double compared = t.compared.placing + t.compared.attacking + t.compared.recording;
+        double then = t.then.placing + t.then.attacking + t.then.recording;
+        cout << "  " << setw(10) << left << entry.first << right << "  place "
+             << 1e6 * t.now.placing / t.games << " us, attack "
+             << 1e6 * t.now.attacking / t.games << " us, record "
+             << 1e6 * t.now.recording / t.games << " us per game";
+        if (then > 0)
+        {
+            cout << "  (" << 1e6 * compared / t.comparedGames << " us in all, baseline "
+                 << 1e6 * then / t.comparedGames << ")";
+            if (tooSlow(compared, then))
+            {
+                cout << "  TOO SLOW";
+                ok = false;
+            }
+        }
+        cout << endl;
+    }
+    cout << (ok ? "Regression check passed" : "Regression check FAILED") << endl;
+    return ok ? 0 : 1;
+}
+
+// corpus [nLayouts [file]]
+// write a corpus of standard fleet layouts for good players to place from
+int runCorpus(int argc, char *argv[])
+{
+    long nLayouts = argc > 2 ? atol(argv[2]) : 1000000;
+    string file = argc > 3 ? argv[3] : STANDARD_CORPUS_FILE;
+    if (nLayouts < 1)
+    {
+        cout << "The number of layouts must be at least 1" << endl;
+        return 1;
+    }
+
+    Game g(10, 10);
+    addStandardShips(g);
+    if (!LayoutCorpus::generate(g, file, nLayouts))
+    {
+        cout << "Could not write " << file << endl;
+        return 1;
+    }
+    cout << "Wrote " << nLayouts << " layouts to " << file << endl;
+    return 0;
+}
+
+// games play file [gamesPerPair [type ...]]
+// games scan file [column ...]
+// play a ladder and log every game to file, or summarize columns of a log
+int runGames(int argc, char *argv[])
+{
+    string mode = argc > 2 ? argv[2] : "";
+    if ((mode != "play" && mode != "scan") || argc < 4)
+    {
+        cout << "usage: games play file [gamesPerPair [type ...]] | games scan file [column ...]" << endl;
+        return 1;
+    }
+    string file = argv[3];
+    if (mode == "play")
+    {
+        int gamesPerPair = argc > 4 ? atoi(argv[4]) : 1000;
+        vector<string> types;
+        for (int i = 5; i < argc; i++)
+            types.push_back(argv[i]);
+        if (types.empty())
+            types = defaultPlayerTypes();
+        if (gamesPerPair < 1)
+        {
+            cout << "The number of games per pair must be at least 1" << endl;
+            return 1;
+        }
+        if (!checkTypes(types))
+            return 1;
+        GameLogWriter log(file, types);
+        if (!log.isOpen())
+        {
+            cout << "Could not write " << file << endl;
+            return 1;
+        }
+        Tournament t(10, 10, addStandardShips);
+        t.setGameLog(&log);
+        vector<PairResult> results = t.roundRobin(types, gamesPerPair);
+        for (const PairResult &res : results)
+            cout << "  " << res.first << " " << res.firstWins << " - " << res.secondWins
+                 << " " << res.second << endl;
+        if (!log.close())
+        {
+            cout << "Could not write " << file << endl;
+            return 1;
+        }
+    }
+
+    GameLogReader log(file);
+    if (!log.isOpen())
+    {
+        cout << "Could not read " << file << endl;
+        return 1;
+    }
+    cout << log.nGames() << " games in " << file << ", " << fixed << setprecision(1)
+         << double(log.size()) / max(1L, log.nGames()) << " bytes per game" << endl;
+    vector<int> columns;
+    for (int i = 4; mode == "scan" && i < argc; i++)
+    {
+        int c = 0;
+        while (c < NLOGCOLUMNS && argv[i] != string(gameLogColumnName(c)))
+            c++;
+        if (c == NLOGCOLUMNS)
+        {
+            cout << "Unknown column " << argv[i] << endl;
+            return 1;
+        }
+        columns.push_back(c);
+    }
+    if (columns.empty())
+        for (int c = 0; c < NLOGCOLUMNS; c++)
+            columns.push_back(c);
+    vector<int64_t> values;
+    for (int c : columns)
+    {
+        auto begin = chrono::steady_clock::now();
+        log.column(c, values);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        double sum = 0;
+        int64_t lo = values.empty() ? 0 : values[0], hi = lo;
+        for (int64_t v : values)
+        {
+            sum += v;
+            lo = min(lo, v);
+            hi = max(hi, v);
+        }
+        cout << "  " << setw(16) << left << gameLogColumnName(c) << right << setw(10)
+             << values.size() << " values, mean " << setw(8) << setprecision(2)
+             << sum / max<size_t>(1, values.size()) << ", range [" << lo << ", " << hi
+             << "], " << setprecision(0) << values.size() / max(seconds, 1e-9) / 1e6
+             << "M values/s" << endl;
+    }
+    return 0;
+}
+
+// sketch [gamesPerPair [type ...]]
+// play a ladder and report, per player type, the spread of its shots to win
+// and of how long it takes to choose a shot, and where its hits landed
+int runSketch(int argc, char *argv[])
+{
+    int gamesPerPair = argc > 2 ? atoi(argv[2]) : 1000;
+    vector<string> types;
+    for (int i = 3; i < argc; i++)
+        types.push_back(argv[i]);
+    if (types.empty())
+        types = defaultPlayerTypes();
+    if (gamesPerPair < 1)
+    {
+        cout << "The number of games per pair must be at least 1" << endl;
+        return 1;
+    }
+    if (!checkTypes(types))
+        return 1;
+
+    const int ROWS = 10, COLS = 10;
+    Tournament t(ROWS, COLS, addStandardShips);
+    t.setSketching(true);
+    cout << "Playing " << gamesPerPair << " games for each pair of " << types.size()
+         << " player types on " << t.nThreads() << " threads" << endl;
+    t.roundRobin(types, gamesPerPair);
+    map<string, GameSketch> sketches = t.sketches();
+    cout << fixed;
+    for (const string &type : types)
+    {
+        const GameSketch &sk = sketches[type];
+        cout << type << ": " << sk.games << " games, " << sk.wins << " wins" << endl;
+        cout << "  shots to win  p50 " << sk.shotsToWin.quantile(0.5) << "  p90 "
+             << sk.shotsToWin.quantile(0.9) << "  p99 " << sk.shotsToWin.quantile(0.99)
+             << "  max " << sk.shotsToWin.max() << endl;
+        cout << setprecision(2) << "  move (us)     p50 " << sk.moveNanos.quantile(0.5) / 1000.0
+             << "  p99 " << sk.moveNanos.quantile(0.99) / 1000.0 << "  max "
+             << sk.moveNanos.max() / 1000.0 << endl;
+        // each cell's share of the hits, in tenths of a percent
+        uint64_t totalHits = 0;
+        for (uint64_t hits : sk.cellHits)
+            totalHits += hits;
+        cout << "  hits per 1000 by cell:" << endl;
+        for (int r = 0; r < ROWS && totalHits > 0 && int(sk.cellHits.size()) == ROWS * COLS; r++)
+        {
+            cout << "   ";
+            for (int c = 0; c < COLS; c++)
+                cout << setw(4) << sk.cellHits[r * COLS + c] * 1000 / totalHits;
+            cout << endl;
+        }
+    }
+    return 0;
+}
+
+// helper function
+// print the best settings a tune has found after a generation
+void reportTune(const TuneResult &best)
+{
+    cout << "  generation " << setw(3) << best.generation << "  " << best.player << "  score "
+         << setprecision(4) << best.score << "  (" << best.evaluations - best.cached << " of "
+         << best.evaluations << " seed pairs played)" << endl;
+}
+
+// tune [type [opponent [generations [population [seeds [cacheFile]]]]]]
+// search the parameters of type for the settings that do best against opponent
+int runTune(int argc, char *argv[])
+{
+    string type = argc > 2 ? argv[2] : "good";
+    string opponent = argc > 3 ? argv[3] : type;
+    TuneSettings settings;
+    if (argc > 4)
+        settings.generations = atoi(argv[4]);
+    if (argc > 5)
+        settings.population = atoi(argv[5]);
+    if (argc > 6)
+        settings.seeds = atoi(argv[6]);
+    string cacheFile = argc > 7 ? argv[7] : "tune.cache";
+    if (settings.generations < 1 || settings.population < 2 || settings.seeds < 1)
+    {
+        cout << "usage: tune [type [opponent [generations [population [seeds [cacheFile]]]]]]" << endl;
+        return 1;
+    }
+    if (!checkTypes({type, opponent}))
+        return 1;
+    vector<PlayerParam> params = playerParams(type);
+    if (params.empty())
+    {
+        cout << type << " has no parameters to tune" << endl;
+        return 1;
+    }
+
+    Tuner tuner(10, 10, addStandardShips);
+    if (!tuner.setCache(cacheFile))
+    {
+        cout << "Could not use " << cacheFile << " as a cache" << endl;
+        return 1;
+    }
+    cout << "Tuning";
+    for (const PlayerParam &param : params)
+        cout << " " << param.name << " [" << param.low << ", " << param.high << "]";
+    cout << " of " << type << " against " << opponent << ": " << settings.generations
+         << " generations of " << settings.population << ", " << settings.seeds
+         << " seed pairs each, on " << tuner.nThreads() << " threads" << endl;
+    cout << fixed;
+    TuneResult best = tuner.tune(type, opponent, settings, reportTune);
+    cout << "Best: " << best.player << " scores " << setprecision(4) << best.score
+         << " against " << opponent << endl;
+    return 0;
+}
+
+// serve address [nWorkers]
+// host games for clients connecting to "unix:<path>" or "tcp:<port>"
+int runServe(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        cout << "usage: serve unix:<path>|tcp:<port> [nWorkers]" << endl;
+        return 1;
+    }
+    int nWorkers = argc > 3 ? atoi(argv[3]) : 0;
+    MatchServer server(10, 10, addStandardShips, nWorkers);
+    if (!server.listen(argv[2]))
+    {
+        cout << "Could not listen on " << argv[2] << endl;
+        return 1;
+    }
+    cout << "Serving games on " << argv[2] << endl;
+    return server.run() ? 0 : 1;
+}
+
+// buildbook [depth [iterations [file]]]
+// search the first depth shots of the standard game and write what mcts
+// plays in each shot state as an opening book, searching only one state of
+// each set that the board's symmetries map onto each other
+int runBuildBook(int argc, char *argv[])
+{
+    int depth = argc > 2 ? atoi(argv[2]) : 4;
+    int iterations = argc > 3 ? atoi(argv[3]) : 20000;
+    string file = argc > 4 ? argv[4] : STANDARD_BOOK_FILE;
+    if (depth < 1 || iterations < 1)
+    {
+        cout << "usage: buildbook [depth [iterations [file]]]" << endl;
+        return 1;
+    }
+    Game g(10, 10);
+    addStandardShips(g);
+    OpeningBook book(g);
+    cout << "Searching the first " << depth << " shots with " << iterations
+         << " iterations per state" << endl;
+    // each level holds the states after that many shots, as the shots that
+    // led there and whether each one hit
+    vector<vector<pair<Cell, bool>>> level(1);
+    int states = 0, searched = 0;
+    for (int d = 0; d < depth; d++)
+    {
+        vector<vector<pair<Cell, bool>>> next;
+        for (const vector<pair<Cell, bool>> &history : level)
+        {
+            ShotState state;
+            for (const pair<Cell, bool> &shot : history)
+            {
+                state.shots.insert(shot.first);
+                if (shot.second)
+                    state.hits.insert(shot.first);
+            }
+            states++;
+            if (book.find(state) != NOCELL) // a mirror image or turn of it was searched
+                continue;
+            // searched afresh, even under a book command
+            Player *p = createMctsPlayer("book", g, iterations, 0, 0, false);
+            for (const pair<Cell, bool> &shot : history)
+                p->recordAttackResultAt(shot.first, true, shot.second, false, -1);
+            Cell cell = p->recommendAttackCell();
+            delete p;
+            book.add(state, cell);
+            searched++;
+            for (bool hit : {false, true})
+            {
+                next.push_back(history);
+                next.back().push_back(make_pair(cell, hit));
+            }
+        }
+        cout << "  " << d << " shots: " << searched << " of " << states << " states searched" << endl;
+        level.swap(next);
+    }
+    if (!book.save(file))
+    {
+        cout << "Could not write " << file << endl;
+        return 1;
+    }
+    cout << book.size() << " entries written to " << file << endl;
+    return 0;
+}
+
+int runCommand(int argc, char *argv[]);
+
+// trace file command [argument ...]
+// run command while recording a timeline of every thread's work to file
+int runTrace(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        cout << "usage: trace file command [argument ...]" << endl;
+        return 1;
+    }
+    startTrace();
+    traceThreadName("main");
+    int status = runCommand(argc - 2, argv + 2);
+    if (!writeTrace(argv[2]))
+    {
+        cout << "Could not write " << argv[2] << endl;
+        return 1;
+    }
+    cout << "Trace written to " << argv[2] << endl;
+    return status;
+}
+
+// layouts file command [argument ...]
+// run command with good players placing their fleets from the corpus in file
+int runLayouts(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        cout << "usage: layouts file command [argument ...]" << endl;
+        return 1;
+    }
+    Game g(10, 10);
+    addStandardShips(g);
+    if (!LayoutCorpus::openShared(g, argv[2]))
+    {
+        cout << argv[2] << " is not a corpus of standard fleet layouts" << endl;
+        return 1;
+    }
+    return runCommand(argc - 2, argv + 2);
+}
+
+// book file command [argument ...]
+// run command with mcts players opening from the book in file
+int runOpeningBook(int argc, char *argv[])
+{
+    if (argc < 4)
+    {
+        cout << "usage: book file command [argument ...]" << endl;
+        return 1;
+    }
+    Game g(10, 10);
+    addStandardShips(g);
+    if (!OpeningBook::openShared(g, argv[2]))
+    {
+        cout << argv[2] << " is not an opening book for the standard game" << endl;
+        return 1;
+    }
+    return runCommand(argc - 2, argv + 2);
+}
+
+// run the command named by argv[1] with the arguments after it
+int runCommand(int argc, char *argv[])
+{
+    string command = argv[1];
+    if (command == "ladder")
+        return runLadder(argc, argv, addStandardShips, "ladder.csv");
+    if (command == "salvo")
+        return runLadder(argc, argv, addSalvoShips, "salvo.csv");
+    if (command == "shards")
+        return runShards(argc, argv);
+    if (command == "sprt")
+        return runSprt(argc, argv);
+    if (command == "paired")
+        return runPaired(argc, argv);
+    if (command == "corpus")
+        return runCorpus(argc, argv);
+    if (command == "placement")
+        return runPlacement(argc, argv);
+    if (command == "harden")
+        return runHarden(argc, argv);
+    if (command == "regress")
+        return runRegress(argc, argv);
+    if (command == "games")
+        return runGames(argc, argv);
+    if (command == "sketch")
+        return runSketch(argc, argv);
+    if (command == "serve")
+        return runServe(argc, argv);
+    if (command == "tune")
+        return runTune(argc, argv);
+    if (command == "buildbook")
+        return runBuildBook(argc, argv);
+    if (command == "book")
+        return runOpeningBook(argc, argv);
+    if (command == "layouts")
+        return runLayouts(argc, argv);
+    if (command == "trace")
+        return runTrace(argc, argv);
+    cout << "Unknown command " << command << endl;
+    return 1;
+}
+
+int main(int argc, char *argv[])
 {
     const int NTRIALS = 1000;
 
+    if (argc > 1)
+        return runCommand(argc, argv);
+
     cout << "Select one of these choices for an example of the game:" << endl;
     cout << "  1.  A mini-game between two mediocre players" << endl;
     cout << "  2.  A computer player against a human player" << endl;
@@ -77,24 +1064,56 @@ int main()
     else if (line[0] == '3')
     {
         int nGoodWins = 0;
+        // on request, keep every game, not just who won, in a log scan can read
+        cout << "File to log the games to (press Enter for none): ";
+        string logFile;
+        getline(cin, logFile);
+        GameLogWriter *log = nullptr;
+        if (!logFile.empty())
+            log = new GameLogWriter(logFile, {"mediocre", "good"});
+        GameRecord record;
+        // a fresh match every time, but one that can be told apart from others
+        unsigned matchSeed = random_device{}();
+        cout << "Match seed " << matchSeed << endl;
 
         for (int k = 1; k <= NTRIALS; k++)
         {
             cout << "============================= Game " << k
                  << " =============================" << endl;
+            seed_seq seeds{matchSeed, unsigned(k)};
+            RandomEngine engine(seeds);
+            RandomEngineScope scope(engine);
             Game g(10, 10);
             addStandardShips(g);
             Player *p1 = createPlayer("mediocre", "Mediocre Mimi", g);
             // Player *p1 = createPlayer("good", "Good Boy", g);
             Player *p2 = createPlayer("good", "Clever Charlie", g);
-            Player *winner = (k % 2 == 1 ? g.play(p1, p2, false) : g.play(p2, p1, false));
+            Player *winner = (k % 2 == 1 ? g.play(p1, p2, false, true, &record.stats)
+                                         : g.play(p2, p1, false, true, &record.stats));
             if (winner == p2)
                 nGoodWins++;
+            record.seed = k;
+            record.firstType = 0;
+            record.secondType = 1;
+            record.firstMover = (k % 2 == 1 ? 0 : 1);
+            record.winner = (winner == p1 ? 1 : winner == p2 ? 2 : 0);
+            if (record.firstMover == 1)
+                record.stats.swapSides();
+            if (log != nullptr)
+                log->add(record);
             delete p1;
             delete p2;
         }
         cout << "The clever player won " << nGoodWins << " out of "
              << NTRIALS << " games." << endl;
+        if (log != nullptr)
+        {
+            if (log->close())
+                cout << "Every game is logged in " << logFile << "; see games scan." << endl;
+            else
+                cout << "Could not write " << logFile << endl;
+            delete log;
+        }
         // We'd expect a mediocre player to win most of the games against
         // an awful player.  Similarly, a good player should outperform
         // a mediocre player.
@@ -0,0 +1,87 @@
+// Check that a game's turns don't allocate: once both fleets are placed,
+// every turn of every pairing of the allocation-free built-in players runs
+// with no call to operator new.  Build and run from the repository root:
+//
+//   g++ -std=c++17 -O2 -pthread -I. tests/alloc_test.cpp $(ls *.cpp | grep -v '^main.cpp$') -o alloc_test && ./alloc_test
+
+#include "FixedGame.h"
+#include "Game.h"
+#include "Player.h"
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace std;
+
+static bool counting = false;
+static long nAllocations = 0;
+
+void *operator new(size_t size)
+{
+    if (counting)
+        nAllocations++;
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == nullptr)
+        throw bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// helper function
+// play nGames games of p1Type against p2Type; return the number of turns
+// played, or -1 after reporting the first turn that allocated
+long countTurns(const string &p1Type, const string &p2Type, int nGames)
+{
+    long nTurns = 0;
+    for (int k = 0; k < nGames; k++)
+    {
+        Game g(10, 10);
+        StandardGame::addShips(g);
+        Player *p1 = createPlayer(p1Type, p1Type, g);
+        Player *p2 = createPlayer(p2Type, p2Type, g);
+        GameSession session(g, p1, p2);
+        bool ok = session.step(); // placement may allocate
+        while (ok)
+        {
+            counting = true;
+            ok = session.step();
+            counting = false;
+            if (nAllocations > 0)
+            {
+                cout << p1Type << " vs " << p2Type << " allocated " << nAllocations
+                     << " times in turn " << session.turnsPlayed() << endl;
+                return -1;
+            }
+            nTurns++;
+        }
+        delete p1;
+        delete p2;
+    }
+    return nTurns;
+}
+
+int main()
+{
+    const string types[] = {"awful", "mediocre", "good"};
+    long nTurns = 0;
+    for (const string &p1Type : types)
+        for (const string &p2Type : types)
+        {
+            long n = countTurns(p1Type, p2Type, 200);
+            if (n < 0)
+                return 1;
+            nTurns += n;
+        }
+    cout << "No allocations in " << nTurns << " turns" << endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Check that the two kinds of fleets a game is played on, a Board and a
+// GameState, report every shot the same way: the same validity, hit and
+// sink flags, and the same ship id, for shots off the board, shots at cells
+// already attacked, and salvos.  Build and run from the repository root:
+//
+//   g++ -std=c++17 -O2 -pthread -I. tests/fleets_test.cpp $(ls *.cpp | grep -v '^main.cpp$') -o fleets_test && ./fleets_test
+
+#include "Board.h"
+#include "FixedGame.h"
+#include "Game.h"
+#include "GameState.h"
+#include "Player.h"
+#include "globals.h"
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+const int NOSHIP = -7; // what shipId holds before an attack, to see if it was set
+
+// helper function
+// report a shot the two fleets disagree on; return false
+bool disagree(int game, int shot, int cell, const char *what)
+{
+    cout << "Game " << game << ", shot " << shot << " at cell " << cell << ": the board and the game state differ in "
+         << what << endl;
+    return false;
+}
+
+// helper function
+// attack the same fleet on a board and a game state, one shot at a time or in
+// salvos, with cells drawn from a little beyond the board; return true if
+// every shot came out the same
+bool playGame(int game, bool salvos)
+{
+    Game g(10, 10);
+    StandardGame::addShips(g);
+    Board b(g);
+    Player *placer = createPlayer("good", "placer", g);
+    GameState state(g.rows(), g.cols());
+    bool ok = placer->placeShips(b) && b.copyShipsTo(state, 1);
+    delete placer;
+    if (!ok)
+    {
+        cout << "Game " << game << ": could not place the fleet" << endl;
+        return false;
+    }
+
+    int shot = 0;
+    vector<Cell> cells;
+    vector<ShotResult> onBoard, onState;
+    while (!b.allShipsDestroyed())
+    {
+        if (!salvos)
+        {
+            Cell cell = randInt(110) - 5;
+            bool boardHit = true, boardSunk = true, stateHit = true, stateSunk = true;
+            int boardId = NOSHIP, stateId = NOSHIP;
+            bool boardValid = b.attack(cell, boardHit, boardSunk, boardId);
+            state.setToMove(0);
+            bool stateValid = state.attack(cell, stateHit, stateSunk, stateId);
+            if (boardValid != stateValid)
+                return disagree(game, shot, cell, "validity");
+            if (boardHit != stateHit || boardSunk != stateSunk)
+                return disagree(game, shot, cell, "hit or sunk");
+            if (boardId != stateId)
+                return disagree(game, shot, cell, "ship id");
+            shot++;
+        }
+        else
+        {
+            cells.clear();
+            for (int n = 1 + randInt(5); n > 0; n--)
+                cells.push_back(randInt(110) - 5);
+            int boardHits = b.attackBatch(cells, onBoard);
+            state.setToMove(0);
+            int stateHits = state.attackBatch(cells, onState);
+            if (boardHits != stateHits)
+                return disagree(game, shot, cells[0], "salvo hits");
+            for (size_t i = 0; i < cells.size(); i++, shot++)
+            {
+                const ShotResult &x = onBoard[i], &y = onState[i];
+                if (x.valid != y.valid || x.hit != y.hit || x.destroyed != y.destroyed ||
+                    (x.hit && x.shipId != y.shipId))
+                    return disagree(game, shot, cells[i], "a salvo result");
+            }
+        }
+        if (b.shipsLeft() != state.side(1).shipsLeft)
+            return disagree(game, shot, -1, "ships left");
+    }
+    if (!state.allShipsDestroyed(1))
+        return disagree(game, shot, -1, "whether the fleet is sunk");
+    return true;
+}
+
+int main()
+{
+    RandomEngine engine(1);
+    RandomEngineScope scope(engine);
+    const int nGames = 2000;
+    for (int k = 0; k < nGames; k++)
+        if (!playGame(k, k % 2 == 1))
+            return 1;
+    cout << "Board and GameState agreed on every shot of " << nGames << " games" << endl;
+    return 0;
+}
@@ -0,0 +1,150 @@
+// Check that a game log round-trips: every column of every game reads back
+// as it was written, across several blocks, for columns that pack best as
+// they are and columns that pack best as differences, and a log cut short
+// reads as the whole blocks before the cut.  Build and run from the
+// repository root:
+//
+//   g++ -std=c++17 -O2 -pthread -I. tests/gamelog_test.cpp $(ls *.cpp | grep -v '^main.cpp$') -o gamelog_test && ./gamelog_test
+
+#include "GameLog.h"
+#include "globals.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// helper function
+// a random game; in the first half of the log the seeds count up, so that
+// column packs as differences, and in the second they are random 64-bit values
+GameRecord randomGame(long k, long nGames)
+{
+    GameRecord r;
+    r.seed = k < nGames / 2 ? 1000 + k : (uint64_t(randInt(1 << 30)) << 34) ^ (uint64_t(randInt(1 << 30)) << 4) ^ randInt(16);
+    r.firstType = randInt(3);
+    r.secondType = randInt(3);
+    r.firstMover = randInt(2);
+    r.winner = randInt(3);
+    r.stats.clear();
+    for (int s = 0; s < 2; s++)
+    {
+        r.stats.shots[s] = 17 + randInt(84);
+        r.stats.wasted[s] = randInt(4) == 0 ? randInt(200) : 0;
+        r.stats.firstHit[s] = randInt(r.stats.shots[s] + 1);
+        for (int n = randInt(6); n > 0; n--)
+            r.stats.sunk[s].push_back(randInt(5));
+    }
+    return r;
+}
+
+// helper function
+// the values column c should hold for games
+vector<int64_t> expectedColumn(const vector<GameRecord> &games, int c)
+{
+    vector<int64_t> values;
+    for (const GameRecord &r : games)
+    {
+        const GameStats &s = r.stats;
+        switch (c)
+        {
+          case LOG_SEED:              values.push_back(int64_t(r.seed)); break;
+          case LOG_FIRST_TYPE:        values.push_back(r.firstType); break;
+          case LOG_SECOND_TYPE:       values.push_back(r.secondType); break;
+          case LOG_FIRST_MOVER:       values.push_back(r.firstMover); break;
+          case LOG_WINNER:            values.push_back(r.winner); break;
+          case LOG_FIRST_SHOTS:       values.push_back(s.shots[0]); break;
+          case LOG_SECOND_SHOTS:      values.push_back(s.shots[1]); break;
+          case LOG_FIRST_WASTED:      values.push_back(s.wasted[0]); break;
+          case LOG_SECOND_WASTED:     values.push_back(s.wasted[1]); break;
+          case LOG_FIRST_HIT_FIRST:   values.push_back(s.firstHit[0]); break;
+          case LOG_SECOND_HIT_FIRST:  values.push_back(s.firstHit[1]); break;
+          case LOG_FIRST_SUNK:        values.push_back(s.sunk[0].size()); break;
+          case LOG_SECOND_SUNK:       values.push_back(s.sunk[1].size()); break;
+          case LOG_FIRST_SINK_ORDER:  values.insert(values.end(), s.sunk[0].begin(), s.sunk[0].end()); break;
+          case LOG_SECOND_SINK_ORDER: values.insert(values.end(), s.sunk[1].begin(), s.sunk[1].end()); break;
+        }
+    }
+    return values;
+}
+
+// helper function
+// read every column of the log in path and compare it with games; return
+// true if they all match
+bool checkLog(const string &path, const vector<GameRecord> &games, const vector<string> &types)
+{
+    GameLogReader reader(path);
+    if (!reader.isOpen() || reader.nGames() != long(games.size()) || reader.types() != types)
+    {
+        cout << path << ": the log does not hold " << games.size() << " games of the types written" << endl;
+        return false;
+    }
+    vector<int64_t> values;
+    for (int c = 0; c < NLOGCOLUMNS; c++)
+    {
+        reader.column(c, values);
+        if (values != expectedColumn(games, c))
+        {
+            cout << path << ": column " << gameLogColumnName(c) << " did not read back as written" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    RandomEngine engine(1);
+    RandomEngineScope scope(engine);
+    const string path = "gamelog_test.log", cutPath = "gamelog_test_cut.log";
+    const vector<string> types = {"awful", "mediocre", "good"};
+    const long nGames = 3 * 4096 + 1234;
+
+    vector<GameRecord> games;
+    {
+        GameLogWriter writer(path, types);
+        for (long k = 0; k < nGames; k++)
+        {
+            games.push_back(randomGame(k, nGames));
+            if (!writer.add(games.back()))
+            {
+                cout << "Could not add game " << k << endl;
+                return 1;
+            }
+        }
+        if (!writer.close())
+        {
+            cout << "Could not write " << path << endl;
+            return 1;
+        }
+    }
+    bool ok = checkLog(path, games, types);
+
+    // cut the log in the middle of its third block
+    if (ok)
+    {
+        GameLogReader whole(path);
+        long cut = whole.size() * 5 / 8;
+        ifstream in(path, ios::binary);
+        string bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        ofstream(cutPath, ios::binary).write(bytes.data(), cut);
+        GameLogReader reader(cutPath);
+        long kept = reader.nGames();
+        if (!reader.isOpen() || kept % 4096 != 0 || kept == 0 || kept >= nGames)
+        {
+            cout << "A log cut to " << cut << " bytes read as " << kept << " games, not whole blocks" << endl;
+            ok = false;
+        }
+        else
+            ok = checkLog(cutPath, vector<GameRecord>(games.begin(), games.begin() + kept), types);
+    }
+    remove(path.c_str());
+    remove(cutPath.c_str());
+    if (!ok)
+        return 1;
+    cout << "A log of " << nGames << " games read back as written, whole and cut short" << endl;
+    return 0;
+}
@@ -0,0 +1,185 @@
+// Check that FleetSampler draws layouts uniformly.  For small fleets, every
+// layout is listed by brute force; the sampler must count the same number,
+// and a chi-square test on its draws must not reject that each layout is
+// equally likely.  The counted draw must also be what the smaller fleets of
+// the regression corpus use, and the fleets it can't count must still be
+// drawn without overlaps.  Build and run from the repository root:
+//
+//   g++ -std=c++17 -O2 -pthread -I. tests/sampler_test.cpp $(ls *.cpp | grep -v '^main.cpp$') -o sampler_test && ./sampler_test
+
+#include "Board.h"
+#include "FleetSampler.h"
+#include "Game.h"
+#include "Regression.h"
+#include "globals.h"
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A layout as the top or left cell and direction of each ship, by ship id
+typedef vector<int> LayoutKey;
+
+// helper function
+// the key of a layout
+LayoutKey keyOf(const Game &g, const vector<ShipPlacement> &layout)
+{
+    LayoutKey key;
+    for (const ShipPlacement &s : layout)
+        key.push_back(2 * (s.topOrLeft.r * g.cols() + s.topOrLeft.c) + (s.dir == VERTICAL));
+    return key;
+}
+
+// helper function
+// add every layout of ships k and up that fits around the cells in used to
+// layouts, numbering them in the order found
+void listLayouts(const Game &g, int k, vector<bool> &used, vector<ShipPlacement> &layout,
+                 map<LayoutKey, int> &layouts)
+{
+    if (k == g.nShips())
+    {
+        layouts.emplace(keyOf(g, layout), int(layouts.size()));
+        return;
+    }
+    int len = g.shipLength(k);
+    for (int r = 0; r < g.rows(); r++)
+        for (int c = 0; c < g.cols(); c++)
+            for (Direction dir : {HORIZONTAL, VERTICAL})
+            {
+                int step = dir == HORIZONTAL ? 1 : g.cols();
+                if ((dir == HORIZONTAL && c + len > g.cols()) || (dir == VERTICAL && r + len > g.rows()) ||
+                    (len == 1 && dir == VERTICAL))
+                    continue;
+                int i;
+                for (i = 0; i < len && !used[r * g.cols() + c + i * step]; i++)
+                    ;
+                if (i < len)
+                    continue;
+                for (i = 0; i < len; i++)
+                    used[r * g.cols() + c + i * step] = true;
+                layout[k] = ShipPlacement{Point(r, c), dir};
+                listLayouts(g, k + 1, used, layout, layouts);
+                for (i = 0; i < len; i++)
+                    used[r * g.cols() + c + i * step] = false;
+            }
+}
+
+// helper function
+// every layout of g's fleet clear of the blocked cells
+map<LayoutKey, int> allLayouts(const Game &g, const vector<Point> &blocked)
+{
+    vector<bool> used(g.rows() * g.cols());
+    for (Point p : blocked)
+        used[p.r * g.cols() + p.c] = true;
+    vector<ShipPlacement> layout(g.nShips());
+    map<LayoutKey, int> layouts;
+    listLayouts(g, 0, used, layout, layouts);
+    return layouts;
+}
+
+// helper function
+// add ships of the given lengths to g
+void addShips(Game &g, const vector<int> &lengths)
+{
+    for (size_t k = 0; k < lengths.size(); k++)
+        g.addShip(lengths[k], char('A' + k), "ship");
+}
+
+// helper function
+// check that the sampler counts the layouts of a fleet of ships of the given
+// lengths and draws them uniformly; return true if it does
+bool checkUniform(const string &name, int rows, int cols, const vector<int> &lengths,
+                  const vector<Point> &blocked = vector<Point>())
+{
+    Game g(rows, cols);
+    addShips(g, lengths);
+    map<LayoutKey, int> layouts = allLayouts(g, blocked);
+    FleetSampler sampler(g, blocked);
+    if (!sampler.countsLayouts() || sampler.nLayouts() != double(layouts.size()))
+    {
+        cout << name << ": the sampler counts " << sampler.nLayouts() << " layouts, not " << layouts.size() << endl;
+        return false;
+    }
+
+    // about 50 draws per layout, so the chi-square statistic is close to its
+    // normal approximation, with mean and variance 1 and 2 per degree of freedom
+    const long perLayout = 50;
+    long nDraws = perLayout * layouts.size();
+    vector<long> drawn(layouts.size(), 0);
+    vector<ShipPlacement> layout;
+    for (long n = 0; n < nDraws; n++)
+    {
+        auto found = sampler.sample(layout) ? layouts.find(keyOf(g, layout)) : layouts.end();
+        if (found == layouts.end())
+        {
+            cout << name << ": the sampler drew a layout that isn't legal" << endl;
+            return false;
+        }
+        drawn[found->second]++;
+    }
+    double chiSquare = 0;
+    for (long count : drawn)
+        chiSquare += double(count - perLayout) * (count - perLayout) / perLayout;
+    double df = layouts.size() - 1;
+    double z = (chiSquare - df) / sqrt(2 * df);
+    cout << name << ": " << layouts.size() << " layouts, chi-square " << chiSquare << " on " << df
+         << " degrees of freedom (z = " << z << ")" << endl;
+    if (z > 5) // the seed is fixed, so this can't fail by chance from run to run
+    {
+        cout << name << ": the draws are not uniform" << endl;
+        return false;
+    }
+    return true;
+}
+
+// helper function
+// check the fleets of the regression corpus: the counted ones must count
+// every layout, at least one must be counted, and every fleet must be drawn
+// without overlaps; return true if they are
+bool checkCorpusFleets()
+{
+    bool anyCounted = false;
+    for (const RegressionCase &c : regressionCorpus())
+    {
+        Game g(c.rows, c.cols);
+        addShips(g, c.shipLengths);
+        const FleetSampler &sampler = FleetSampler::shared(g);
+        if (sampler.countsLayouts())
+        {
+            anyCounted = true;
+            size_t nLayouts = allLayouts(g, vector<Point>()).size();
+            if (sampler.nLayouts() != double(nLayouts))
+            {
+                cout << c.name << ": the sampler counts " << sampler.nLayouts() << " layouts, not " << nLayouts
+                     << endl;
+                return false;
+            }
+        }
+        Board b(g);
+        for (int n = 0; n < 1000; n++)
+            if (!sampler.placeShips(b))
+            {
+                cout << c.name << ": the sampler could not place the fleet" << endl;
+                return false;
+            }
+    }
+    if (!anyCounted)
+        cout << "The sampler counts none of the regression corpus fleets" << endl;
+    return anyCounted;
+}
+
+int main()
+{
+    RandomEngine engine(1);
+    RandomEngineScope scope(engine);
+    if (!checkUniform("2x3 rowboat", 2, 3, {2}) || !checkUniform("3x4 with ships 3 2 1", 3, 4, {3, 2, 1}) ||
+        !checkUniform("4x4 with ships 3 2 2", 4, 4, {3, 2, 2}) ||
+        !checkUniform("4x5 with ships 3 3 2 and two cells blocked", 4, 5, {3, 3, 2}, {Point(1, 1), Point(2, 3)}) ||
+        !checkCorpusFleets())
+        return 1;
+    cout << "The sampler drew every fleet uniformly" << endl;
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Check that board symmetries and the opening book round-trip: every
+// symmetry is undone by its inverse, canonicalize gives the same canonical
+// state for every image of a state and a symmetry that maps it back, and a
+// shot added to a book for one state is found, turned to fit, for each of
+// its images, before and after the book is saved and loaded.  Build and run
+// from the repository root:
+//
+//   g++ -std=c++17 -O2 -pthread -I. tests/symmetry_test.cpp $(ls *.cpp | grep -v '^main.cpp$') -o symmetry_test && ./symmetry_test
+
+#include "FixedGame.h"
+#include "Game.h"
+#include "OpeningBook.h"
+#include "Symmetry.h"
+#include "globals.h"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// helper function
+// report a failed check for the board; return false
+bool fail(const Game &g, const string &what)
+{
+    cout << g.rows() << "x" << g.cols() << " board: " << what << endl;
+    return false;
+}
+
+// helper function
+// a random shot state, with nShots cells shot at and about a third of them hits
+ShotState randomState(int nCells, int nShots)
+{
+    ShotState state;
+    while (state.shots.size() < nShots)
+    {
+        Cell cell = randInt(nCells);
+        state.shots.insert(cell);
+        if (randInt(3) == 0)
+            state.hits.insert(cell);
+    }
+    return state;
+}
+
+// helper function
+// return true if two shot states are the same
+bool sameState(const ShotState &a, const ShotState &b)
+{
+    return a.shots == b.shots && a.hits == b.hits;
+}
+
+// helper function
+// return true if found is shot turned by a symmetry that takes state to
+// image; a state some symmetry leaves alone has more than one such turn
+bool turnedShot(const BoardSymmetry &sym, const ShotState &state, Cell shot, const ShotState &image, Cell found)
+{
+    for (int t = 0; t < sym.count(); t++)
+        if (sameState(sym.map(state, t), image) && sym.map(shot, t) == found)
+            return true;
+    return false;
+}
+
+// helper function
+// run every check on g's board; return true if all of them pass
+bool checkBoard(const Game &g, const string &bookFile)
+{
+    const BoardSymmetry &sym = BoardSymmetry::shared(g.rows(), g.cols());
+    int nCells = g.rows() * g.cols();
+    if (sym.count() != (g.rows() == g.cols() ? 8 : 4))
+        return fail(g, "wrong number of symmetries");
+    for (int t = 0; t < sym.count(); t++)
+        for (Cell cell = 0; cell < nCells; cell++)
+            if (sym.map(sym.map(cell, t), sym.inverse(t)) != cell)
+                return fail(g, "symmetry " + to_string(t) + " is not undone by its inverse");
+
+    OpeningBook book(g);
+    const int nStates = 300;
+    ShotState states[nStates];
+    Cell shots[nStates];
+    for (int k = 0; k < nStates; k++)
+    {
+        ShotState state = randomState(nCells, 1 + randInt(nCells / 2));
+        ShotState canonical;
+        int t = sym.canonicalize(state, canonical);
+        if (!sameState(sym.map(canonical, sym.inverse(t)), state))
+            return fail(g, "a canonical state does not map back to its state");
+        for (int u = 0; u < sym.count(); u++)
+        {
+            ShotState image = sym.map(state, u), imageCanonical;
+            sym.canonicalize(image, imageCanonical);
+            if (!sameState(imageCanonical, canonical))
+                return fail(g, "two images of a state have different canonical forms");
+        }
+        Cell shot;
+        do
+            shot = randInt(nCells);
+        while (state.shots.contains(shot));
+        states[k] = state;
+        shots[k] = shot;
+        book.add(state, shot);
+    }
+
+    OpeningBook loaded(g);
+    if (!book.save(bookFile) || !loaded.load(bookFile))
+        return fail(g, "could not save and load the book");
+    remove(bookFile.c_str());
+    if (loaded.size() != book.size())
+        return fail(g, "the loaded book has a different size");
+    for (int k = 0; k < nStates; k++)
+    {
+        // a later state with the same canonical form replaces the entry
+        ShotState canonical;
+        sym.canonicalize(states[k], canonical);
+        bool replaced = false;
+        for (int j = k + 1; j < nStates && !replaced; j++)
+        {
+            ShotState other;
+            sym.canonicalize(states[j], other);
+            replaced = sameState(other, canonical);
+        }
+        if (replaced)
+            continue;
+        for (int u = 0; u < sym.count(); u++)
+        {
+            ShotState image = sym.map(states[k], u);
+            if (!turnedShot(sym, states[k], shots[k], image, book.find(image)) ||
+                !turnedShot(sym, states[k], shots[k], image, loaded.find(image)))
+                return fail(g, "a book entry was not found for an image of its state");
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    RandomEngine engine(1);
+    RandomEngineScope scope(engine);
+    const string bookFile = "symmetry_test.book";
+
+    Game standard(10, 10);
+    StandardGame::addShips(standard);
+    Game square(7, 7);
+    square.addShip(3, 'S', "submarine");
+    square.addShip(2, 'D', "destroyer");
+    Game oblong(8, 11);
+    oblong.addShip(4, 'B', "battleship");
+    oblong.addShip(2, 'D', "destroyer");
+
+    for (const Game *g : {&standard, &square, &oblong})
+        if (!checkBoard(*g, bookFile))
+            return 1;
+    cout << "Symmetries and the opening book round-tripped on every board" << endl;
+    return 0;
+}